@@ -0,0 +1,122 @@
+/// @file ascii.hpp
+/// @author Michael Koch
+/// @copyright CC BY 3.0
+
+#ifndef __TAGSOUP_ASCII_HPP__
+#define __TAGSOUP_ASCII_HPP__
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+namespace ts
+{
+
+	/// @brief lowers ASCII upper case letters, leaves all other bytes untouched
+	/// @param c byte to lower
+	/// @return lowered byte
+	constexpr char to_lower(const char c)
+	{
+		return (c >= 'A' && c <= 'Z') ? static_cast<char>(c | 0x20) : c;
+	}
+
+	/// @brief tests for ASCII letters independently of the current locale
+	/// @param c byte to test
+	/// @retval true \a c is one of 'a' to 'z' or 'A' to 'Z'
+	/// @retval false \a c is some other byte
+	constexpr bool is_alpha(const char c)
+	{
+		return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+	}
+
+	/// @brief tests for ASCII digits
+	/// @param c byte to test
+	/// @retval true \a c is one of '0' to '9'
+	/// @retval false \a c is some other byte
+	constexpr bool is_digit(const char c)
+	{
+		return c >= '0' && c <= '9';
+	}
+
+	/// @brief tests for ASCII letters and digits independently of the current locale
+	/// @param c byte to test
+	/// @retval true \a c is a letter or a digit
+	/// @retval false \a c is some other byte
+	constexpr bool is_alnum(const char c)
+	{
+		return is_alpha(c) || is_digit(c);
+	}
+
+	/// @brief tests for white space as classified by the C locale
+	/// @param c byte to test
+	/// @retval true \a c is one of space, tab, line feed, vertical tab, form feed or carriage return
+	/// @retval false \a c is no white space
+	constexpr bool is_space(const char c)
+	{
+		return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+	}
+
+	/// @brief compares two bytes ignoring ASCII case
+	/// @param a first byte
+	/// @param b second byte
+	/// @retval true bytes are equal apart from ASCII case
+	/// @retval false bytes differ
+	constexpr bool equals_ignoring_case(const char a, const char b)
+	{
+		return to_lower(a) == to_lower(b);
+	}
+
+	/// @brief compares a string with a byte sequence ignoring ASCII case
+	/// @param a string to compare
+	/// @param b first byte of sequence to compare with
+	/// @param size number of bytes of \a b
+	/// @retval true both are equal apart from ASCII case
+	/// @retval false both differ
+	inline bool equals_ignoring_case(const std::string & a, const char * b, const std::size_t size)
+	{
+		if (a.size() != size) return false;
+		for (std::size_t i = 0; i < size; ++i)
+			if (!equals_ignoring_case(a[i], b[i])) return false;
+		return true;
+	}
+
+	/// @brief compares two byte sequences of equal length ignoring ASCII case
+	/// @param a first byte of the first sequence
+	/// @param b first byte of the second sequence
+	/// @param size number of bytes to compare
+	/// @retval true both are equal apart from ASCII case
+	/// @retval false both differ
+	inline bool equals_ignoring_case(const char * a, const char * b, const std::size_t size)
+	{
+		for (std::size_t i = 0; i < size; ++i)
+			if (!equals_ignoring_case(a[i], b[i])) return false;
+		return true;
+	}
+
+	/// @brief lowers all ASCII upper case letters of a string in place
+	/// @param s string to lower
+	inline void lower(std::string & s)
+	{
+		for (auto & c : s) c = to_lower(c);
+	}
+
+	/// @class accept_id_ignoring_case
+	/// @brief predicate for parser::parse_until_closing_tag which accepts one id regardless of its ASCII case
+	/// @details No string is built for the comparison, i.e. `</SCRIPT>` is accepted by
+	///			`accept_id_ignoring_case("script")` without any allocation.
+	class accept_id_ignoring_case
+	{
+		private:
+			const char * id;
+			std::size_t size;
+		public:
+			/// @param id id to accept; must outlive the predicate
+			accept_id_ignoring_case(const char * id) : id(id), size(std::strlen(id)) {}
+			accept_id_ignoring_case(const std::string & id) : id(id.data()), size(id.size()) {}
+
+			bool operator () (const std::string & candidate) const {return equals_ignoring_case(candidate, id, size);}
+	};
+
+}
+
+#endif
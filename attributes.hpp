@@ -0,0 +1,327 @@
+/// @file attributes.hpp
+/// @author Michael Koch
+/// @copyright CC BY 3.0
+
+#ifndef __TAGSOUP_ATTRIBUTES_HPP__
+#define __TAGSOUP_ATTRIBUTES_HPP__
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <memory>
+#include <new>
+#include <utility>
+#include <initializer_list>
+
+namespace ts
+{
+
+	/// @brief FNV-1a hash over a sequence of bytes
+	/// @param data first byte
+	/// @param size number of bytes
+	/// @return hash value
+	inline std::uint64_t hash_bytes(const char * data, const std::size_t size)
+	{
+		std::uint64_t hash = 14695981039346656037ull;
+		for (std::size_t i = 0; i < size; ++i)
+		{
+			hash ^= static_cast<unsigned char>(data[i]);
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	/// @class attribute_list
+	/// @brief sequence of attribute name value pairs, stored in a block that is recycled per thread
+	/// @details The list itself is a single pointer to a heap block holding the pairs, so it adds no more than eight
+	///			bytes to the size of each tag_token, which is a union of all tag kinds. A list without attributes
+	///			has no block. Blocks for up to \a small_capacity attributes are not freed but kept in a small cache
+	///			of the destroying thread and reused by the next list, hence tokenizing a stream of small tags does
+	///			not allocate once the first tag has been seen; only tokens which are kept alive hold a block each.
+	///			Larger lists grow on the heap. Once build_index has been called on a list with more than
+	///			\a indexing_threshold entries, find answers in constant time by means of an open addressing hash
+	///			table; smaller lists are searched linearly.
+	class attribute_list
+	{
+		public:
+			using value_type = std::pair<std::string, std::string>;
+			using iterator = value_type *;
+			using const_iterator = const value_type *;
+
+			/// number of attributes of a block which is recycled instead of freed
+			static const std::size_t small_capacity = 4;
+
+			/// minimal number of attributes for which build_index creates a hash table
+			static const std::size_t indexing_threshold = 8;
+
+		private:
+			/// @brief header of a block, followed by storage for \a capacity pairs
+			struct block
+			{
+				/// number of attributes
+				std::uint32_t count;
+
+				/// number of attributes which fit into the block
+				std::uint32_t capacity;
+
+				/// number of slots minus one
+				std::uint32_t slot_mask;
+
+				/// hash table of positions plus one (zero marks an empty slot), null if there is no index
+				std::unique_ptr<std::uint32_t[]> slots;
+
+				inline value_type * pairs() {return reinterpret_cast<value_type*>(this + 1);}
+			};
+			static_assert(sizeof(block) % alignof(value_type) == 0, "pairs must follow the block header aligned");
+
+			/// @brief freed small blocks of one thread
+			struct block_cache
+			{
+				static const std::size_t size = 8;
+
+				block * blocks[size];
+				std::size_t count = 0;
+
+				/// false once the thread is exiting, later lists free their blocks right away
+				bool alive = true;
+
+				~block_cache()
+				{
+					for (std::size_t i = 0; i < count; ++i) ::operator delete(blocks[i]);
+					count = 0;
+					alive = false;
+				}
+			};
+
+			static block_cache & get_cache()
+			{
+				static thread_local block_cache cache;
+				return cache;
+			}
+
+			/// @brief gives an empty block, recycled if possible
+			/// @param wanted minimal capacity
+			static block * acquire(const std::size_t wanted)
+			{
+				block_cache & cache = get_cache();
+				block * b;
+				if (wanted <= small_capacity && cache.count != 0) b = cache.blocks[--cache.count];
+				else
+				{
+					const std::size_t capacity = wanted <= small_capacity ? small_capacity : wanted;
+					b = new (::operator new(sizeof(block) + capacity * sizeof(value_type))) block();
+					b->capacity = static_cast<std::uint32_t>(capacity);
+				}
+				b->count = 0;
+				b->slot_mask = 0;
+				return b;
+			}
+
+			/// @brief gives back a block whose pairs have been destructed
+			static void recycle(block * b)
+			{
+				b->slots.reset();
+				block_cache & cache = get_cache();
+				if (b->capacity == small_capacity && cache.alive && cache.count != block_cache::size) cache.blocks[cache.count++] = b;
+				else
+				{
+					b->~block();
+					::operator delete(b);
+				}
+			}
+
+			/// storage of the attributes, null if there are none
+			block * storage;
+
+			/// @brief moves all attributes into a block of at least \a wanted attributes
+			/// @param wanted minimal capacity
+			void grow(const std::size_t wanted)
+			{
+				const std::size_t capacity = storage != nullptr ? storage->capacity : 0;
+				block * next = acquire(capacity * 2 < wanted ? wanted : capacity * 2);
+				if (storage != nullptr)
+				{
+					value_type * pairs = storage->pairs();
+					for (std::uint32_t i = 0; i < storage->count; ++i)
+					{
+						new (next->pairs() + i) value_type(std::move(pairs[i]));
+						pairs[i].~value_type();
+					}
+					next->count = storage->count;
+					recycle(storage);
+				}
+				storage = next;
+			}
+
+			/// @brief destructs all attributes and gives back the block
+			void release()
+			{
+				if (storage == nullptr) return;
+				clear();
+				recycle(storage);
+				storage = nullptr;
+			}
+
+		public:
+			attribute_list() : storage(nullptr)
+			{}
+
+			attribute_list(std::initializer_list<value_type> pairs) : attribute_list()
+			{
+				reserve(pairs.size());
+				for (const auto & pair : pairs) push_back(pair);
+			}
+
+			/// @brief takes over the pairs of a vector
+			/// @param pairs attribute name value pairs
+			attribute_list(std::vector<value_type> pairs) : attribute_list()
+			{
+				reserve(pairs.size());
+				for (auto & pair : pairs) push_back(std::move(pair));
+			}
+
+			attribute_list(attribute_list && other) noexcept : storage(other.storage)
+			{
+				other.storage = nullptr;
+			}
+
+			attribute_list(const attribute_list & other) : attribute_list()
+			{
+				reserve(other.size());
+				for (const auto & pair : other) push_back(pair);
+				if (other.storage != nullptr && other.storage->slots) build_index();
+			}
+
+			~attribute_list()
+			{
+				release();
+			}
+
+			attribute_list& operator = (attribute_list && other) noexcept
+			{
+				if (this != &other)
+				{
+					release();
+					storage = other.storage;
+					other.storage = nullptr;
+				}
+				return *this;
+			}
+
+			attribute_list& operator = (const attribute_list & other)
+			{
+				if (this != &other)
+				{
+					clear();
+					reserve(other.size());
+					for (const auto & pair : other) push_back(pair);
+					if (other.storage != nullptr && other.storage->slots) build_index();
+				}
+				return *this;
+			}
+
+			inline std::size_t size() const {return storage != nullptr ? storage->count : 0;}
+			inline bool empty() const {return size() == 0;}
+
+			inline iterator begin() {return storage != nullptr ? storage->pairs() : nullptr;}
+			inline iterator end() {return begin() + size();}
+			inline const_iterator begin() const {return const_cast<attribute_list*>(this)->begin();}
+			inline const_iterator end() const {return begin() + size();}
+			inline const_iterator cbegin() const {return begin();}
+			inline const_iterator cend() const {return end();}
+
+			inline value_type& operator [] (const std::size_t i) {return storage->pairs()[i];}
+			inline const value_type& operator [] (const std::size_t i) const {return storage->pairs()[i];}
+
+			/// @brief ensures that \a wanted attributes can be stored without further allocation
+			/// @param wanted number of attributes
+			void reserve(const std::size_t wanted)
+			{
+				if (wanted != 0 && (storage == nullptr || wanted > storage->capacity)) grow(wanted);
+			}
+
+			/// @brief appends an attribute
+			/// @param name attribute name
+			/// @param value attribute value
+			/// @note an existing index gets dropped
+			void emplace_back(std::string name, std::string value)
+			{
+				if (storage == nullptr || storage->count == storage->capacity) grow(size() + 1);
+				new (storage->pairs() + storage->count) value_type(std::move(name), std::move(value));
+				++storage->count;
+				storage->slots.reset();
+			}
+
+			void push_back(value_type && pair) {emplace_back(std::move(pair.first), std::move(pair.second));}
+			void push_back(const value_type & pair) {emplace_back(pair.first, pair.second);}
+
+			/// @brief removes the last attribute
+			/// @pre list is not empty
+			void pop_back()
+			{
+				storage->pairs()[--storage->count].~value_type();
+				storage->slots.reset();
+			}
+
+			/// @brief destructs all attributes, but keeps the storage
+			void clear()
+			{
+				if (storage == nullptr) return;
+				value_type * pairs = storage->pairs();
+				for (std::uint32_t i = 0; i < storage->count; ++i) pairs[i].~value_type();
+				storage->count = 0;
+				storage->slots.reset();
+			}
+
+			/// @brief creates the hash table used by find if there are more than \a indexing_threshold attributes
+			/// @details If a name appears multiple times, find keeps returning the first occurrence.
+			void build_index()
+			{
+				if (storage == nullptr) return;
+				storage->slots.reset();
+				const std::uint32_t count = storage->count;
+				if (count <= indexing_threshold) return;
+
+				std::uint32_t size = 16;
+				while (size < 2 * count) size *= 2;
+				storage->slots.reset(new std::uint32_t[size]());
+				storage->slot_mask = size - 1;
+
+				const value_type * pairs = storage->pairs();
+				std::uint32_t * slots = storage->slots.get();
+				for (std::uint32_t i = 0; i < count; ++i)
+				{
+					const std::string & name = pairs[i].first;
+					std::uint32_t slot = static_cast<std::uint32_t>(hash_bytes(name.data(), name.size())) & storage->slot_mask;
+					while (slots[slot] != 0 && pairs[slots[slot] - 1].first != name) slot = (slot + 1) & storage->slot_mask;
+					if (slots[slot] == 0) slots[slot] = i + 1;
+				}
+			}
+
+			/// @brief looks for the first attribute with a specific name
+			/// @param name attribute name
+			/// @return iterator to the attribute or end() if there is none
+			const_iterator find(const std::string & name) const
+			{
+				const_iterator first = begin();
+				if (storage != nullptr && storage->slots)
+				{
+					const std::uint32_t * slots = storage->slots.get();
+					std::uint32_t slot = static_cast<std::uint32_t>(hash_bytes(name.data(), name.size())) & storage->slot_mask;
+					while (slots[slot] != 0)
+					{
+						if (first[slots[slot] - 1].first == name) return first + slots[slot] - 1;
+						slot = (slot + 1) & storage->slot_mask;
+					}
+					return end();
+				}
+				for (std::size_t i = 0; i < size(); ++i)
+					if (first[i].first == name) return first + i;
+				return end();
+			}
+	};
+
+}
+
+#endif
@@ -0,0 +1,185 @@
+/// @file batch.hpp
+/// @author Michael Koch
+/// @copyright CC BY 3.0
+
+#ifndef __TAGSOUP_BATCH_HPP__
+#define __TAGSOUP_BATCH_HPP__
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <algorithm>
+#include <tagsoup/parser.hpp>
+#include <tagsoup/document.hpp>
+
+namespace ts
+{
+
+	/// @class batch_tokenizer
+	/// @brief tokenizes many independent documents on a work stealing thread pool
+	/// @details Documents get dealt round robin to per thread queues. A thread takes jobs from the front of its own
+	///			queue and, once that runs dry, steals from the back of the other queues; so a few huge documents do not
+	///			leave the other threads idle. Every thread keeps one token buffer which is reused for all documents it
+	///			processes in callback mode. The payloads of the tokens are allocated by the global allocator, there are
+	///			no per thread arenas; only attribute lists keep a few freed blocks per thread for reuse.
+	class batch_tokenizer
+	{
+		private:
+
+			/// @struct job_queue
+			/// @brief indices of documents waiting for one thread
+			struct job_queue
+			{
+				std::mutex mutex;
+				std::deque<std::size_t> jobs;
+			};
+
+			parser tokenizer;
+			std::size_t thread_count;
+
+			/// @brief takes the next job, either from own queue or from some other
+			/// @param queues all queues
+			/// @param own index of own queue
+			/// @param job set to the taken job
+			/// @retval true some job has been taken
+			/// @retval false all queues are empty
+			static bool take(std::vector<job_queue> & queues, const std::size_t own, std::size_t & job)
+			{
+				{
+					std::lock_guard<std::mutex> lock(queues[own].mutex);
+					if (!queues[own].jobs.empty())
+					{
+						job = queues[own].jobs.front();
+						queues[own].jobs.pop_front();
+						return true;
+					}
+				}
+				for (std::size_t i = 1; i < queues.size(); ++i)
+				{
+					job_queue & victim = queues[(own + i) % queues.size()];
+					std::lock_guard<std::mutex> lock(victim.mutex);
+					if (!victim.jobs.empty())
+					{
+						job = victim.jobs.back();
+						victim.jobs.pop_back();
+						return true;
+					}
+				}
+				return false;
+			}
+
+			/// @brief runs \a work(thread, job) for all jobs on the pool
+			/// @param jobs number of jobs
+			/// @param work callable with signature void(std::size_t, std::size_t)
+			/// @details The first exception thrown by \a work is rethrown after all threads have finished. If starting a
+			///			thread fails, the threads already started are stopped and joined before the exception is passed on.
+			template <typename Work>
+			void run(const std::size_t jobs, Work work) const
+			{
+				const std::size_t threads = std::max<std::size_t>(1, std::min(thread_count, jobs));
+				std::vector<job_queue> queues(threads);
+				for (std::size_t job = 0; job < jobs; ++job) queues[job % threads].jobs.push_back(job);
+
+				std::exception_ptr failure;
+				std::mutex failure_mutex;
+				std::atomic<bool> failed(false);
+				auto loop = [&](const std::size_t thread)
+				{
+					std::size_t job;
+					while (!failed.load(std::memory_order_relaxed) && take(queues, thread, job))
+					{
+						try {work(thread, job);}
+						catch (...)
+						{
+							std::lock_guard<std::mutex> lock(failure_mutex);
+							if (!failure) failure = std::current_exception();
+							failed = true;
+						}
+					}
+				};
+
+				std::vector<std::thread> pool;
+				try
+				{
+					pool.reserve(threads - 1);
+					for (std::size_t thread = 1; thread < threads; ++thread) pool.emplace_back(loop, thread);
+				}
+				catch (...)
+				{
+					// e.g. std::system_error once no more threads can be started; a joinable thread must not be destructed
+					failed = true;
+					for (auto & thread : pool) thread.join();
+					throw;
+				}
+				loop(0);
+				for (auto & thread : pool) thread.join();
+				if (failure) std::rethrow_exception(failure);
+			}
+
+		public:
+
+			/// @param tokenizer parser (and hence its options) used for every document
+			/// @param thread_count number of threads including the calling one; zero picks the number of hardware threads
+			batch_tokenizer(const parser & tokenizer = parser(), const std::size_t thread_count = 0) :
+				tokenizer(tokenizer),
+				thread_count(thread_count != 0 ? thread_count : std::max<std::size_t>(1, std::thread::hardware_concurrency()))
+			{}
+
+			inline std::size_t get_thread_count() const {return thread_count;}
+			inline const parser& get_parser() const {return tokenizer;}
+
+			/// @brief tokenizes documents and hands over their tokens as soon as a document is done
+			/// @tparam Callback callable with signature void(std::size_t, std::vector<tag_token> &)
+			/// @param documents documents to tokenize; they must stay alive until the call returns
+			/// @param callback gets the index of the document and its tokens
+			/// @note \a callback is called concurrently from all threads and in no particular order. The token vector is
+			///			the buffer of the calling thread; it may be moved from or swapped, otherwise it gets cleared and reused.
+			template <typename Callback>
+			void tokenize(const std::vector<document_view> & documents, Callback callback) const
+			{
+				std::vector<std::vector<tag_token>> buffers(std::max<std::size_t>(1, std::min(thread_count, documents.size())));
+				run(documents.size(), [&](const std::size_t thread, const std::size_t job)
+				{
+					std::vector<tag_token> & tokens = buffers[thread];
+					tokens.clear();
+					size_t line = 1;
+					size_t column = 0;
+					tokenizer.parse_all(documents[job].begin(), documents[job].end(), line, column,
+							[&tokens](tag_token && token){tokens.push_back(std::move(token));});
+					callback(job, tokens);
+				});
+			}
+
+			/// @brief tokenizes documents and gives their tokens in document order
+			/// @param documents documents to tokenize
+			/// @return tokens of each document at the index of the document
+			std::vector<std::vector<tag_token>> tokenize(const std::vector<document_view> & documents) const
+			{
+				std::vector<std::vector<tag_token>> results(documents.size());
+				tokenize(documents, [&results](const std::size_t job, std::vector<tag_token> & tokens)
+				{
+					results[job].swap(tokens);
+				});
+				return results;
+			}
+
+			/// @brief tokenizes documents and gives their tokens in document order
+			/// @param documents documents to tokenize
+			/// @return tokens of each document at the index of the document
+			std::vector<std::vector<tag_token>> tokenize(const std::vector<std::string> & documents) const
+			{
+				std::vector<document_view> views;
+				views.reserve(documents.size());
+				for (const auto & document : documents) views.push_back(document_view{document.data(), document.size()});
+				return tokenize(views);
+			}
+	};
+
+}
+
+#endif
@@ -0,0 +1,474 @@
+/// @file diff.hpp
+/// @author Michael Koch
+/// @copyright CC BY 3.0
+
+#ifndef __TAGSOUP_DIFF_HPP__
+#define __TAGSOUP_DIFF_HPP__
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <tagsoup/parser.hpp>
+#include <tagsoup/tags.hpp>
+#include <tagsoup/attributes.hpp>
+#include <tagsoup/token_table.hpp>
+
+namespace ts
+{
+
+	/// @enum change_type
+	/// @brief kinds of differences between two versions of a document
+	enum class change_type : std::uint8_t
+	{
+		/// only in the new version
+		inserted,
+		/// only in the old version
+		removed,
+		/// same kind and id, but different attributes or payload
+		modified
+	};
+
+	/// @struct token_change
+	/// @brief difference of one token
+	/// @details \a old_position is the position in the old sequence where the change happens, i.e. of the removed or
+	///			modified token or of the token in front of which the insertion goes; \a new_position likewise.
+	struct token_change
+	{
+		change_type type;
+		std::size_t old_position;
+		std::size_t new_position;
+	};
+
+	/// @struct attribute_change
+	/// @brief difference of one attribute of a modified tag
+	struct attribute_change
+	{
+		change_type type;
+		std::string name;
+	};
+
+	/// @struct hashed_tokens
+	/// @brief compact form of a token sequence for diffing
+	/// @details \a hashes covers everything of a token, \a shapes only its kind and id, so that two tokens of equal
+	///			shape but different hash are the same element with changed attributes or payload.
+	struct hashed_tokens
+	{
+		std::vector<std::uint64_t> hashes;
+		std::vector<std::uint64_t> shapes;
+
+		inline std::size_t size() const {return hashes.size();}
+	};
+
+	/// @brief hashes a token sequence
+	/// @param tokens tokens of one document
+	/// @return hash and shape of each token
+	inline hashed_tokens hash_tokens(const std::vector<tag_token> & tokens)
+	{
+		struct hasher
+		{
+			std::uint64_t hash;
+
+			inline void add(const std::string & s)
+			{
+				// the length keeps ("ab", "c") apart from ("a", "bc")
+				hash = (hash ^ hash_bytes(s.data(), s.size())) * 1099511628211ull + s.size();
+			}
+
+			inline void add_attributes(attribute_list::const_iterator first, const attribute_list::const_iterator last)
+			{
+				for (; first != last; ++first) {add(first->first); add(first->second);}
+			}
+		};
+
+		hashed_tokens result;
+		result.hashes.reserve(tokens.size());
+		result.shapes.reserve(tokens.size());
+		for (const tag_token & token : tokens)
+		{
+			const tag_kind kind = get_kind(token);
+			hasher h{14695981039346656037ull + static_cast<std::uint64_t>(kind)};
+			switch (kind)
+			{
+				case tag_kind::open_tag: h.add(token.get<open_tag>().get_id()); break;
+				case tag_kind::closing_tag: h.add(token.get<closing_tag>().get_id()); break;
+				case tag_kind::empty_tag: h.add(token.get<empty_tag>().get_id()); break;
+				case tag_kind::pi: h.add(token.get<pi>().get_id()); break;
+				case tag_kind::dtd: h.add(token.get<dtd>().get_id()); break;
+				default: break;
+			}
+			result.shapes.push_back(h.hash);
+			switch (kind)
+			{
+				case tag_kind::open_tag:
+					h.add_attributes(token.get<open_tag>().cbegin_attributes(), token.get<open_tag>().cend_attributes());
+					break;
+				case tag_kind::empty_tag:
+					h.add_attributes(token.get<empty_tag>().cbegin_attributes(), token.get<empty_tag>().cend_attributes());
+					break;
+				case tag_kind::comment: h.add(token.get<comment>().get_content()); break;
+				case tag_kind::text: h.add(token.get<text>().get_content()); break;
+				case tag_kind::pi: h.add(token.get<pi>().get_code()); break;
+				case tag_kind::cdata: h.add(token.get<cdata>().get_code()); break;
+				case tag_kind::unknown_tag: h.add(token.get<unknown_tag>().get_description()); break;
+				default: break;
+			}
+			result.hashes.push_back(h.hash);
+		}
+		return result;
+	}
+
+	/// @brief hashes the rows of a token table
+	/// @param table tokens of one document
+	/// @return hash and shape of each row
+	/// @details Values are hashed as they appear in the source, neither lowered nor unescaped, and the span of an
+	///			unknown_tag stands in for its description; hence only tables are comparable with each other.
+	inline hashed_tokens hash_tokens(const token_table & table)
+	{
+		hashed_tokens result;
+		result.hashes.reserve(table.size());
+		result.shapes.reserve(table.size());
+		for (std::size_t i = 0; i < table.size(); ++i)
+		{
+			const tag_kind kind = table.get_kind(i);
+			const document_view value = table.get_value(i);
+			const bool named = kind != tag_kind::text && kind != tag_kind::comment && kind != tag_kind::cdata;
+			std::uint64_t hash = (14695981039346656037ull + static_cast<std::uint64_t>(kind)) * 1099511628211ull;
+			if (named) hash = (hash ^ hash_bytes(value.data, value.size)) * 1099511628211ull + value.size;
+			result.shapes.push_back(hash);
+
+			// the whole span holds the attributes or the payload
+			const document_view span = table.get_span(i);
+			hash = (hash ^ hash_bytes(span.data, span.size)) * 1099511628211ull + span.size;
+			result.hashes.push_back(hash);
+		}
+		return result;
+	}
+
+	/// @class token_differ
+	/// @brief computes the differences between two token sequences of the same page
+	/// @details The core is Myers' O((N+M)D) algorithm in its linear space variant: the middle snake of the edit
+	///			graph is found by searching from both ends at once, then both halves are solved recursively. Only
+	///			hashes are compared, and common prefixes and suffixes are cut off first, so a re-crawled page with a
+	///			few changes costs little more than one pass over both sequences.
+	///
+	///			The edit script is minimal as long as the search of a range needs at most \a cost_limit steps from
+	///			each end. A range that differs more is split at its anchors instead, the tokens whose hash occurs
+	///			exactly once in both versions of the range, of which the longest common subsequence is kept as in
+	///			patience diff; the gaps between anchors are compared again. A range without anchors is taken as
+	///			removed and inserted as a whole. Thus a page whose every text has changed costs about as much as one
+	///			with a few changes.
+	///
+	///			Within each gap between common tokens, removed and inserted tokens of equal shape are paired in order
+	///			as modified, looking at most \a pairing_window inserted tokens ahead; a pair of equal hashes, which
+	///			only a range without anchors leaves behind, stays unchanged. Equal hashes are taken for equal tokens;
+	///			with 64 bit hashes a collision is unlikely, but not impossible.
+	class token_differ
+	{
+		public:
+			/// number of inserted tokens searched for a partner of a removed token
+			static const std::size_t pairing_window = 64;
+
+			/// number of differences searched from each end of a range before it is split at anchors
+			static const std::size_t cost_limit = 256;
+
+		private:
+			/// @brief occurrences of a hash within the compared ranges
+			struct occurrence
+			{
+				std::size_t old_count;
+				std::size_t new_count;
+				std::size_t new_position;
+			};
+
+			const std::uint64_t * a;
+			const std::uint64_t * b;
+
+			/// furthest reaching paths of the forward and the backward search, reused by all bisections
+			std::vector<std::ptrdiff_t> forward;
+			std::vector<std::ptrdiff_t> backward;
+
+			/// removals and insertions in document order, the modified ones are found afterwards
+			std::vector<token_change> edits;
+
+			/// occurrences of the hashes of the range being anchored
+			std::unordered_map<std::uint64_t, occurrence> occurrences;
+
+			/// @brief finds a point on a shortest edit path through the middle snake
+			/// @return false if the ranges differ in more than about 2 * \a cost_limit tokens, otherwise true and the
+			///			offsets into both ranges where the problem splits, or n, 0 if nothing is common
+			bool bisect(const std::size_t a_first, const std::size_t n, const std::size_t b_first, const std::size_t m,
+				std::size_t & x_split, std::size_t & y_split)
+			{
+				const std::ptrdiff_t N = n;
+				const std::ptrdiff_t M = m;
+				const std::ptrdiff_t max_d = (N + M + 1) / 2;
+				// the search never goes further than the bound, so neither do the paths
+				const std::ptrdiff_t bound = std::min(max_d, static_cast<std::ptrdiff_t>(cost_limit) + 1);
+				const std::ptrdiff_t offset = bound;
+				const std::ptrdiff_t length = 2 * bound;
+				forward.assign(length, -1);
+				backward.assign(length, -1);
+				forward[offset + 1] = 0;
+				backward[offset + 1] = 0;
+				const std::ptrdiff_t delta = N - M;
+				// if the difference is odd, the forward search meets the backward one, otherwise vice versa
+				const bool front = (delta & 1) != 0;
+				std::ptrdiff_t k1_start = 0, k1_end = 0, k2_start = 0, k2_end = 0;
+				const std::uint64_t * x_seq = a + a_first;
+				const std::uint64_t * y_seq = b + b_first;
+
+				for (std::ptrdiff_t d = 0; d < max_d; ++d)
+				{
+					if (d == bound) return false;
+
+					for (std::ptrdiff_t k1 = -d + k1_start; k1 <= d - k1_end; k1 += 2)
+					{
+						const std::ptrdiff_t k1_offset = offset + k1;
+						std::ptrdiff_t x1 = (k1 == -d || (k1 != d && forward[k1_offset - 1] < forward[k1_offset + 1]))
+							? forward[k1_offset + 1] : forward[k1_offset - 1] + 1;
+						std::ptrdiff_t y1 = x1 - k1;
+						while (x1 < N && y1 < M && x_seq[x1] == y_seq[y1]) {++x1; ++y1;}
+						forward[k1_offset] = x1;
+						if (x1 > N) k1_end += 2;
+						else if (y1 > M) k1_start += 2;
+						else if (front)
+						{
+							const std::ptrdiff_t k2_offset = offset + delta - k1;
+							if (k2_offset >= 0 && k2_offset < length && backward[k2_offset] != -1 && x1 >= N - backward[k2_offset])
+							{
+								x_split = x1;
+								y_split = y1;
+								return true;
+							}
+						}
+					}
+
+					for (std::ptrdiff_t k2 = -d + k2_start; k2 <= d - k2_end; k2 += 2)
+					{
+						const std::ptrdiff_t k2_offset = offset + k2;
+						std::ptrdiff_t x2 = (k2 == -d || (k2 != d && backward[k2_offset - 1] < backward[k2_offset + 1]))
+							? backward[k2_offset + 1] : backward[k2_offset - 1] + 1;
+						std::ptrdiff_t y2 = x2 - k2;
+						while (x2 < N && y2 < M && x_seq[N - x2 - 1] == y_seq[M - y2 - 1]) {++x2; ++y2;}
+						backward[k2_offset] = x2;
+						if (x2 > N) k2_end += 2;
+						else if (y2 > M) k2_start += 2;
+						else if (!front)
+						{
+							const std::ptrdiff_t k1_offset = offset + delta - k2;
+							if (k1_offset >= 0 && k1_offset < length && forward[k1_offset] != -1)
+							{
+								const std::ptrdiff_t x1 = forward[k1_offset];
+								if (x1 >= N - x2)
+								{
+									x_split = x1;
+									y_split = x1 - (k1_offset - offset);
+									return true;
+								}
+							}
+						}
+					}
+				}
+				x_split = n;
+				y_split = 0;
+				return true;
+			}
+
+			/// @brief splits two ranges at the tokens which are unique in both and compares the gaps between them
+			/// @return false if there is no such token
+			bool anchor(const std::size_t a_first, const std::size_t a_last, const std::size_t b_first, const std::size_t b_last)
+			{
+				occurrences.clear();
+				for (std::size_t i = a_first; i != a_last; ++i) ++occurrences[a[i]].old_count;
+				for (std::size_t j = b_first; j != b_last; ++j)
+				{
+					const auto o = occurrences.find(b[j]);
+					if (o == occurrences.end()) continue;
+					++o->second.new_count;
+					o->second.new_position = j;
+				}
+
+				// candidates in old order, of which the longest increasing run of new positions is kept by patience
+				// sorting: tops[k] is the candidate ending the best run of length k + 1 found so far
+				std::vector<std::pair<std::size_t, std::size_t>> candidates;
+				for (std::size_t i = a_first; i != a_last; ++i)
+				{
+					const occurrence & o = occurrences[a[i]];
+					if (o.old_count == 1 && o.new_count == 1) candidates.emplace_back(i, o.new_position);
+				}
+				if (candidates.empty()) return false;
+
+				std::vector<std::size_t> tops;
+				std::vector<std::size_t> previous(candidates.size());
+				for (std::size_t c = 0; c != candidates.size(); ++c)
+				{
+					const auto top = std::lower_bound(tops.begin(), tops.end(), candidates[c].second,
+						[&candidates](const std::size_t t, const std::size_t position) {return candidates[t].second < position;});
+					previous[c] = top != tops.begin() ? *(top - 1) : candidates.size();
+					if (top == tops.end()) tops.push_back(c);
+					else *top = c;
+				}
+
+				std::vector<std::size_t> anchors(tops.size());
+				for (std::size_t c = tops.back(), k = tops.size(); k != 0; c = previous[c]) anchors[--k] = c;
+
+				std::size_t i = a_first;
+				std::size_t j = b_first;
+				for (const std::size_t c : anchors)
+				{
+					compare(i, candidates[c].first, j, candidates[c].second);
+					i = candidates[c].first + 1;
+					j = candidates[c].second + 1;
+				}
+				compare(i, a_last, j, b_last);
+				return true;
+			}
+
+			void compare(std::size_t a_first, std::size_t a_last, std::size_t b_first, std::size_t b_last)
+			{
+				while (a_first != a_last && b_first != b_last && a[a_first] == b[b_first]) {++a_first; ++b_first;}
+				while (a_first != a_last && b_first != b_last && a[a_last - 1] == b[b_last - 1]) {--a_last; --b_last;}
+
+				if (a_first == a_last || b_first == b_last)
+				{
+					for (std::size_t i = a_first; i != a_last; ++i) edits.push_back(token_change{change_type::removed, i, b_first});
+					for (std::size_t j = b_first; j != b_last; ++j) edits.push_back(token_change{change_type::inserted, a_last, j});
+					return;
+				}
+
+				std::size_t x, y;
+				if (!bisect(a_first, a_last - a_first, b_first, b_last - b_first, x, y))
+				{
+					if (anchor(a_first, a_last, b_first, b_last)) return;
+					x = a_last - a_first;
+					y = 0;
+				}
+				if (x == a_last - a_first && y == 0)
+				{
+					// nothing in common, or too much differing to tell
+					for (std::size_t i = a_first; i != a_last; ++i) edits.push_back(token_change{change_type::removed, i, b_first});
+					for (std::size_t j = b_first; j != b_last; ++j) edits.push_back(token_change{change_type::inserted, a_last, j});
+					return;
+				}
+				compare(a_first, a_first + x, b_first, b_first + y);
+				compare(a_first + x, a_last, b_first + y, b_last);
+			}
+
+			/// @brief turns removed and inserted tokens of equal shape into modified ones, gap by gap
+			std::vector<token_change> pair(const hashed_tokens & old_tokens, const hashed_tokens & new_tokens) const
+			{
+				std::vector<token_change> changes;
+				changes.reserve(edits.size());
+				std::vector<const token_change *> removed;
+				std::vector<const token_change *> inserted;
+				std::size_t i = 0;
+				while (i != edits.size())
+				{
+					// a gap ends where the next edit does not continue at the position the previous one has left
+					removed.clear();
+					inserted.clear();
+					std::size_t old_position = edits[i].old_position;
+					std::size_t new_position = edits[i].new_position;
+					for (; i != edits.size() && edits[i].old_position == old_position && edits[i].new_position == new_position; ++i)
+					{
+						if (edits[i].type == change_type::removed) {removed.push_back(&edits[i]); ++old_position;}
+						else {inserted.push_back(&edits[i]); ++new_position;}
+					}
+
+					std::size_t next = 0;
+					for (const token_change * r : removed)
+					{
+						// an equal token is preferred to one of equal shape
+						const std::size_t window = next + pairing_window < inserted.size() ? next + pairing_window : inserted.size();
+						std::size_t q = next;
+						while (q != window && old_tokens.hashes[r->old_position] != new_tokens.hashes[inserted[q]->new_position]) ++q;
+						const bool equal = q != window;
+						if (!equal)
+						{
+							q = next;
+							while (q != window && old_tokens.shapes[r->old_position] != new_tokens.shapes[inserted[q]->new_position]) ++q;
+						}
+						if (q == window)
+						{
+							const std::size_t at = next != inserted.size() ? inserted[next]->new_position : new_position;
+							changes.push_back(token_change{change_type::removed, r->old_position, at});
+							continue;
+						}
+						for (; next != q; ++next) changes.push_back(token_change{change_type::inserted, r->old_position, inserted[next]->new_position});
+						if (!equal) changes.push_back(token_change{change_type::modified, r->old_position, inserted[q]->new_position});
+						next = q + 1;
+					}
+					for (; next != inserted.size(); ++next) changes.push_back(token_change{change_type::inserted, old_position, inserted[next]->new_position});
+				}
+				return changes;
+			}
+
+		public:
+			token_differ() : a(nullptr), b(nullptr) {}
+
+			/// @brief compares two versions of a document
+			/// @param old_tokens hashed tokens of the old version
+			/// @param new_tokens hashed tokens of the new version
+			/// @return changes in document order, empty if both versions are equal
+			std::vector<token_change> diff(const hashed_tokens & old_tokens, const hashed_tokens & new_tokens)
+			{
+				a = old_tokens.hashes.data();
+				b = new_tokens.hashes.data();
+				edits.clear();
+				compare(0, old_tokens.size(), 0, new_tokens.size());
+				return pair(old_tokens, new_tokens);
+			}
+	};
+
+	/// @brief compares two versions of a document
+	/// @param old_tokens tokens of the old version
+	/// @param new_tokens tokens of the new version
+	/// @return changes in document order, see token_differ
+	inline std::vector<token_change> diff_tokens(const std::vector<tag_token> & old_tokens, const std::vector<tag_token> & new_tokens)
+	{
+		token_differ differ;
+		return differ.diff(hash_tokens(old_tokens), hash_tokens(new_tokens));
+	}
+
+	/// @brief compares the attributes of two versions of a tag, e.g. of a modified change
+	/// @param old_token old version, an open or empty tag
+	/// @param new_token new version, an open or empty tag
+	/// @return removed and modified attributes in the order of the old tag, then the inserted ones
+	inline std::vector<attribute_change> diff_attributes(const tag_token & old_token, const tag_token & new_token)
+	{
+		std::vector<attribute_change> changes;
+		auto compare = [&changes](const attribute_list::const_iterator old_first, const attribute_list::const_iterator old_last,
+			const attribute_list::const_iterator new_first, const attribute_list::const_iterator new_last)
+		{
+			for (auto i = old_first; i != old_last; ++i)
+			{
+				auto j = new_first;
+				while (j != new_last && j->first != i->first) ++j;
+				if (j == new_last) changes.push_back(attribute_change{change_type::removed, i->first});
+				else if (j->second != i->second) changes.push_back(attribute_change{change_type::modified, i->first});
+			}
+			for (auto j = new_first; j != new_last; ++j)
+			{
+				auto i = old_first;
+				while (i != old_last && i->first != j->first) ++i;
+				if (i == old_last) changes.push_back(attribute_change{change_type::inserted, j->first});
+			}
+		};
+
+		const attribute_list no_attributes;
+		auto old_first = no_attributes.cbegin(), old_last = no_attributes.cend();
+		auto new_first = no_attributes.cbegin(), new_last = no_attributes.cend();
+		if (old_token.is_type<open_tag>()) {old_first = old_token.get<open_tag>().cbegin_attributes(); old_last = old_token.get<open_tag>().cend_attributes();}
+		else if (old_token.is_type<empty_tag>()) {old_first = old_token.get<empty_tag>().cbegin_attributes(); old_last = old_token.get<empty_tag>().cend_attributes();}
+		if (new_token.is_type<open_tag>()) {new_first = new_token.get<open_tag>().cbegin_attributes(); new_last = new_token.get<open_tag>().cend_attributes();}
+		else if (new_token.is_type<empty_tag>()) {new_first = new_token.get<empty_tag>().cbegin_attributes(); new_last = new_token.get<empty_tag>().cend_attributes();}
+		compare(old_first, old_last, new_first, new_last);
+		return changes;
+	}
+
+}
+
+#endif
@@ -0,0 +1,100 @@
+/// @file dispatcher.hpp
+/// @author Michael Koch
+/// @copyright CC BY 3.0
+
+#ifndef __TAGSOUP_DISPATCHER_HPP__
+#define __TAGSOUP_DISPATCHER_HPP__
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <functional>
+#include <tagsoup/parser.hpp>
+#include <tagsoup/tags.hpp>
+
+namespace ts
+{
+
+	/// set of tag kinds, one bit per tag_kind
+	typedef std::uint16_t kind_mask;
+
+	/// mask holding every tag kind
+	const kind_mask all_kinds = (1u << tag_kind_count) - 1;
+
+	/// @brief gives the bit of a tag kind
+	/// @param kind kind of tag
+	/// @return mask holding only \a kind
+	inline kind_mask get_kind_mask(const tag_kind kind)
+	{
+		return static_cast<kind_mask>(1u << static_cast<unsigned>(kind));
+	}
+
+	/// @class token_dispatcher
+	/// @brief tokenizes a document once and hands every token to all consumers interested in its kind
+	/// @details Each consumer is registered with a kind_mask; a token costs one mask test per consumer and a call of
+	///			those which want it. Consumers get the token by const reference, so none of them may move from it.
+	///			Kinds no consumer wants are not even materialised: run skips the payload of texts, comments, CDATA
+	///			sections and processing instructions if nobody asks for them.
+	class token_dispatcher
+	{
+		public:
+			typedef std::function<void(const tag_token &)> consumer;
+
+		private:
+			std::vector<kind_mask> masks;
+			std::vector<consumer> consumers;
+
+			/// union of the masks of all consumers
+			kind_mask wanted;
+
+		public:
+			token_dispatcher() : wanted(0) {}
+
+			inline std::size_t size() const {return consumers.size();}
+
+			/// @brief gives the union of the kinds of all consumers
+			inline kind_mask get_wanted_kinds() const {return wanted;}
+
+			/// @brief registers a consumer
+			/// @param kinds kinds of tokens the consumer gets
+			/// @param c callable with signature void(const tag_token &)
+			/// @return index of the consumer
+			std::size_t add_consumer(const kind_mask kinds, consumer c)
+			{
+				masks.push_back(kinds);
+				consumers.push_back(std::move(c));
+				wanted |= kinds;
+				return consumers.size() - 1;
+			}
+
+			/// @brief hands a token to all consumers interested in its kind
+			/// @param token token to hand over
+			void dispatch(const tag_token & token) const
+			{
+				const kind_mask bit = get_kind_mask(get_kind(token));
+				if ((wanted & bit) == 0) return;
+				for (std::size_t i = 0; i < consumers.size(); ++i)
+					if ((masks[i] & bit) != 0) consumers[i](token);
+			}
+
+			/// @brief tokenizes a whole document and dispatches its tokens
+			/// @tparam InputIterator type concept input iterator
+			/// @return position where parsing has stopped, see parser::parse_all
+			/// @param tokenizer parser to use; its skip options are switched on for kinds no consumer wants
+			/// @param start first iterator position of text to parse
+			/// @param end first iterator after last position of text to parse
+			template <typename InputIterator>
+			InputIterator run(const parser & tokenizer, InputIterator start, InputIterator end, size_t & line, size_t & column) const
+			{
+				parser scanner(tokenizer);
+				if ((wanted & get_kind_mask(tag_kind::text)) == 0) scanner.skip_text(true);
+				if ((wanted & get_kind_mask(tag_kind::comment)) == 0) scanner.skip_comment(true);
+				if ((wanted & get_kind_mask(tag_kind::cdata)) == 0) scanner.skip_cdata(true);
+				if ((wanted & get_kind_mask(tag_kind::pi)) == 0) scanner.skip_pi(true);
+				return scanner.parse_all(start, end, line, column, [this](tag_token && token){dispatch(token);});
+			}
+	};
+
+}
+
+#endif
@@ -0,0 +1,31 @@
+/// @file document.hpp
+/// @author Michael Koch
+/// @copyright CC BY 3.0
+
+#ifndef __TAGSOUP_DOCUMENT_HPP__
+#define __TAGSOUP_DOCUMENT_HPP__
+
+#include <cstddef>
+#include <string>
+
+namespace ts
+{
+
+	/// @struct document_view
+	/// @brief non owning view onto a document or some part of it in memory
+	struct document_view
+	{
+		const char * data;
+		std::size_t size;
+
+		inline const char * begin() const {return data;}
+		inline const char * end() const {return data + size;}
+
+		/// @brief copies the viewed bytes
+		/// @return string holding the viewed bytes
+		inline std::string to_string() const {return std::string(data, size);}
+	};
+
+}
+
+#endif
@@ -0,0 +1,291 @@
+/// @file encoding.hpp
+/// @author Michael Koch
+/// @copyright CC BY 3.0
+
+#ifndef __TAGSOUP_ENCODING_HPP__
+#define __TAGSOUP_ENCODING_HPP__
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <tagsoup/ascii.hpp>
+
+namespace ts
+{
+
+	/// @brief character encodings the front-end can transcode to UTF-8
+	enum class encoding : std::uint8_t
+	{
+		unknown = 0,
+		utf8,
+		utf16le,
+		utf16be,
+		latin1,
+		windows1252
+	};
+
+	/// @struct encoding_detection
+	/// @brief result of sniffing the start of a document
+	struct encoding_detection
+	{
+		/// detected encoding, unknown if neither a byte order mark nor a meta charset has been found
+		encoding detected;
+
+		/// number of bytes of the byte order mark which must not be transcoded
+		std::size_t bom_size;
+	};
+
+	/// @brief maps a charset label to an encoding
+	/// @param label first byte of the label
+	/// @param size number of bytes of the label
+	/// @return encoding or encoding::unknown for unsupported labels
+	/// @details As browsers do, ASCII and ISO-8859-1 labels select Windows-1252, and UTF-16 labels from inside the
+	///			document select UTF-8, since a document which could be read as ASCII cannot be UTF-16.
+	inline encoding get_encoding(const char * label, const std::size_t size)
+	{
+		static const struct {const char * label; encoding value;} labels[] = {
+			{"utf-8", encoding::utf8}, {"utf8", encoding::utf8}, {"unicode-1-1-utf-8", encoding::utf8},
+			{"utf-16", encoding::utf8}, {"utf-16le", encoding::utf8}, {"utf-16be", encoding::utf8},
+			{"windows-1252", encoding::windows1252}, {"cp1252", encoding::windows1252}, {"x-cp1252", encoding::windows1252},
+			{"iso-8859-1", encoding::windows1252}, {"iso8859-1", encoding::windows1252}, {"latin1", encoding::windows1252},
+			{"l1", encoding::windows1252}, {"us-ascii", encoding::windows1252}, {"ascii", encoding::windows1252},
+			{"iso_8859-1", encoding::windows1252}, {"cp819", encoding::windows1252}, {"ibm819", encoding::windows1252}
+		};
+		std::string lowered(label, size);
+		lower(lowered);
+		for (const auto & entry : labels)
+			if (lowered == entry.label) return entry.value;
+		return encoding::unknown;
+	}
+
+	/// @brief looks for a byte order mark
+	/// @param data first bytes of the document
+	/// @param size number of available bytes
+	/// @return detected encoding and size of the mark; encoding::unknown if there is no mark
+	inline encoding_detection detect_bom(const char * data, const std::size_t size)
+	{
+		const unsigned char * bytes = reinterpret_cast<const unsigned char*>(data);
+		if (size >= 3 && bytes[0] == 0xEF && bytes[1] == 0xBB && bytes[2] == 0xBF) return encoding_detection{encoding::utf8, 3};
+		if (size >= 2 && bytes[0] == 0xFF && bytes[1] == 0xFE) return encoding_detection{encoding::utf16le, 2};
+		if (size >= 2 && bytes[0] == 0xFE && bytes[1] == 0xFF) return encoding_detection{encoding::utf16be, 2};
+		return encoding_detection{encoding::unknown, 0};
+	}
+
+	/// @brief prescans the start of a document for a charset given by a meta element
+	/// @param data first bytes of the document
+	/// @param size number of available bytes; at most the first 1024 bytes are considered
+	/// @return encoding of the first supported charset label or encoding::unknown
+	/// @details Both `<meta charset="...">` and `<meta http-equiv=... content="...; charset=...">` are found, since
+	///			the label is searched after 'charset' within the meta tag. Comments are skipped.
+	inline encoding detect_meta_charset(const char * data, std::size_t size)
+	{
+		if (size > 1024) size = 1024;
+		const char * const end = data + size;
+		const char * i = data;
+		while (i != end)
+		{
+			i = static_cast<const char*>(std::memchr(i, '<', end - i));
+			if (i == nullptr) break;
+			if (end - i >= 4 && std::memcmp(i, "<!--", 4) == 0)
+			{
+				const char * close = i + 4;
+				while (close + 3 <= end && std::memcmp(close, "-->", 3) != 0) ++close;
+				i = close + 3 <= end ? close + 3 : end;
+				continue;
+			}
+			if (end - i >= 6 && equals_ignoring_case(i + 1, "meta", 4) && (is_space(i[5]) || i[5] == '/'))
+			{
+				const char * tag_end = static_cast<const char*>(std::memchr(i, '>', end - i));
+				if (tag_end == nullptr) tag_end = end;
+				for (const char * j = i + 5; j + 7 <= tag_end; ++j)
+				{
+					if (!equals_ignoring_case(j, "charset", 7)) continue;
+					const char * k = j + 7;
+					while (k != tag_end && is_space(*k)) ++k;
+					if (k == tag_end || *k != '=') continue;
+					++k;
+					while (k != tag_end && (is_space(*k) || *k == '"' || *k == '\'')) ++k;
+					const char * label = k;
+					while (k != tag_end && (is_alnum(*k) || *k == '-' || *k == '_' || *k == '.' || *k == ':')) ++k;
+					const encoding found = get_encoding(label, k - label);
+					if (found != encoding::unknown) return found;
+				}
+				i = tag_end;
+				continue;
+			}
+			++i;
+		}
+		return encoding::unknown;
+	}
+
+	/// @brief sniffs the encoding of a document from its first bytes
+	/// @param data first bytes of the document
+	/// @param size number of available bytes
+	/// @param fallback encoding assumed if neither a byte order mark nor a meta charset is found
+	/// @return encoding and number of bytes of the byte order mark
+	inline encoding_detection detect_encoding(const char * data, const std::size_t size, const encoding fallback = encoding::utf8)
+	{
+		encoding_detection detection = detect_bom(data, size);
+		if (detection.detected != encoding::unknown) return detection;
+		detection.detected = detect_meta_charset(data, size);
+		if (detection.detected == encoding::unknown) detection.detected = fallback;
+		return detection;
+	}
+
+	/// @class transcoder
+	/// @brief converts blocks of some encoding to UTF-8
+	/// @details Sequences split between two blocks are kept until the next call. Runs of ASCII are copied eight
+	///			bytes at a time: a word is tested with a single mask instead of byte by byte. Invalid UTF-16 (unpaired
+	///			surrogates, a dangling byte at the end) becomes U+FFFD; UTF-8 passes through unchecked.
+	class transcoder
+	{
+		private:
+			encoding from;
+
+			/// UTF-16 byte of an incomplete code unit
+			unsigned char pending_byte;
+			bool has_pending_byte;
+
+			/// high surrogate waiting for its low surrogate, zero if none
+			std::uint16_t pending_surrogate;
+
+			/// maps bytes 0x80 to 0x9F of Windows-1252 to code points
+			static std::uint16_t get_windows1252(const unsigned char b)
+			{
+				static const std::uint16_t table[32] = {
+					0x20AC, 0x0081, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021, 0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0x008D, 0x017D, 0x008F,
+					0x0090, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014, 0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0x009D, 0x017E, 0x0178
+				};
+				return (b >= 0x80 && b < 0xA0) ? table[b - 0x80] : b;
+			}
+
+			static void append(std::string & out, const std::uint32_t code_point)
+			{
+				if (code_point < 0x80) out.push_back(static_cast<char>(code_point));
+				else if (code_point < 0x800)
+				{
+					out.push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+					out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+				}
+				else if (code_point < 0x10000)
+				{
+					out.push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+					out.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+					out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+				}
+				else
+				{
+					out.push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+					out.push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+					out.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+					out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+				}
+			}
+
+			/// @brief tests eight bytes against a mask given in memory order
+			static bool none_of(const unsigned char * bytes, const unsigned char (&mask)[8])
+			{
+				std::uint64_t word;
+				std::uint64_t bits;
+				std::memcpy(&word, bytes, 8);
+				std::memcpy(&bits, mask, 8);
+				return (word & bits) == 0;
+			}
+
+			void single_byte(const unsigned char * bytes, const std::size_t size, std::string & out)
+			{
+				static const unsigned char high[8] = {0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80};
+				std::size_t i = 0;
+				while (i < size)
+				{
+					if (i + 8 <= size && none_of(bytes + i, high))
+					{
+						out.append(reinterpret_cast<const char*>(bytes + i), 8);
+						i += 8;
+						continue;
+					}
+					const unsigned char b = bytes[i++];
+					append(out, from == encoding::windows1252 ? get_windows1252(b) : b);
+				}
+			}
+
+			void code_unit(const std::uint16_t unit, std::string & out)
+			{
+				if (pending_surrogate != 0)
+				{
+					if (unit >= 0xDC00 && unit <= 0xDFFF)
+					{
+						append(out, 0x10000 + ((pending_surrogate - 0xD800) << 10) + (unit - 0xDC00));
+						pending_surrogate = 0;
+						return;
+					}
+					append(out, 0xFFFD);
+					pending_surrogate = 0;
+				}
+				if (unit >= 0xD800 && unit <= 0xDBFF) pending_surrogate = unit;
+				else if (unit >= 0xDC00 && unit <= 0xDFFF) append(out, 0xFFFD);
+				else append(out, unit);
+			}
+
+			void utf16(const unsigned char * bytes, const std::size_t size, std::string & out)
+			{
+				static const unsigned char ascii_le[8] = {0x80, 0xFF, 0x80, 0xFF, 0x80, 0xFF, 0x80, 0xFF};
+				static const unsigned char ascii_be[8] = {0xFF, 0x80, 0xFF, 0x80, 0xFF, 0x80, 0xFF, 0x80};
+				const bool little = from == encoding::utf16le;
+				std::size_t i = 0;
+				if (has_pending_byte && size > 0)
+				{
+					code_unit(little ? (pending_byte | (bytes[0] << 8)) : ((pending_byte << 8) | bytes[0]), out);
+					has_pending_byte = false;
+					i = 1;
+				}
+				while (i + 1 < size)
+				{
+					if (pending_surrogate == 0 && i + 8 <= size && none_of(bytes + i, little ? ascii_le : ascii_be))
+					{
+						for (std::size_t k = little ? 0 : 1; k < 8; k += 2) out.push_back(static_cast<char>(bytes[i + k]));
+						i += 8;
+						continue;
+					}
+					code_unit(little ? (bytes[i] | (bytes[i + 1] << 8)) : ((bytes[i] << 8) | bytes[i + 1]), out);
+					i += 2;
+				}
+				if (i < size)
+				{
+					pending_byte = bytes[i];
+					has_pending_byte = true;
+				}
+			}
+
+		public:
+			transcoder(const encoding from = encoding::utf8) : from(from), pending_byte(0), has_pending_byte(false), pending_surrogate(0)
+			{}
+
+			inline encoding get_encoding() const {return from;}
+
+			/// @brief appends the UTF-8 form of a block
+			/// @param data first byte of the block
+			/// @param size number of bytes of the block
+			/// @param out string to append to
+			void transcode(const char * data, const std::size_t size, std::string & out)
+			{
+				const unsigned char * bytes = reinterpret_cast<const unsigned char*>(data);
+				if (from == encoding::utf16le || from == encoding::utf16be) utf16(bytes, size, out);
+				else if (from == encoding::latin1 || from == encoding::windows1252) single_byte(bytes, size, out);
+				else out.append(data, size);
+			}
+
+			/// @brief ends the input, replacing an incomplete sequence by U+FFFD
+			/// @param out string to append to
+			void finish(std::string & out)
+			{
+				if (has_pending_byte || pending_surrogate != 0) append(out, 0xFFFD);
+				has_pending_byte = false;
+				pending_surrogate = 0;
+			}
+	};
+
+}
+
+#endif
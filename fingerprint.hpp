@@ -0,0 +1,143 @@
+/// @file fingerprint.hpp
+/// @author Michael Koch
+/// @copyright CC BY 3.0
+
+#ifndef __TAGSOUP_FINGERPRINT_HPP__
+#define __TAGSOUP_FINGERPRINT_HPP__
+
+#include <cstdint>
+#include <cstddef>
+#include <tagsoup/parser.hpp>
+#include <tagsoup/tags.hpp>
+#include <tagsoup/ascii.hpp>
+#include <tagsoup/attributes.hpp>
+
+namespace ts
+{
+
+	/// @brief gives the number of differing bits of two fingerprints
+	/// @param a first SimHash
+	/// @param b second SimHash
+	/// @return Hamming distance, small for near duplicates
+	inline unsigned get_distance(const std::uint64_t a, const std::uint64_t b)
+	{
+		std::uint64_t x = a ^ b;
+		unsigned n = 0;
+		for (; x != 0; x &= x - 1) ++n;
+		return n;
+	}
+
+	/// @class fingerprint
+	/// @brief structural hashes of a document, fed with its tokens while tokenizing
+	/// @details Every open, empty and closing tag contributes the hash of its kind and id to a rolling hash of the
+	///			tag skeleton, which is equal for documents with the same sequence of tags. For near duplicates it
+	///			also feeds a SimHash: its features are shingles of three consecutive tags and, for each text run
+	///			that is not just white space, the enclosing tag together with the magnitude of the text length.
+	///			Features are spread over 64 counters, one per bit, so the fingerprint needs a fixed amount of
+	///			memory and no allocation. Ids are hashed as the tokens hold them, see parser options for lowering.
+	///			The fingerprint is fed from the token callback rather than from inside the scanner: it hashes the id
+	///			string of each tag once more and updates all 64 counters per feature. Both are cheap next to
+	///			building the token, and the parser stays free of a hashing state that most callers never need.
+	class fingerprint
+	{
+		private:
+			static const std::size_t shingle_size = 3;
+
+			std::uint64_t structure;
+			std::int32_t weights[64];
+
+			/// hashes of the last tags, \a recent[tags % shingle_size] is the oldest
+			std::uint64_t recent[shingle_size];
+			std::uint64_t tags;
+			std::uint64_t features;
+
+			/// @brief spreads the bits of a hash, FNV-1a alone is too weak for single SimHash bits
+			inline static std::uint64_t mix(std::uint64_t x)
+			{
+				x ^= x >> 30;
+				x *= 0xbf58476d1ce4e5b9ull;
+				x ^= x >> 27;
+				x *= 0x94d049bb133111ebull;
+				x ^= x >> 31;
+				return x;
+			}
+
+			void add_feature(const std::uint64_t feature)
+			{
+				const std::uint64_t bits = mix(feature);
+				for (unsigned i = 0; i < 64; ++i) weights[i] += ((bits >> i) & 1) != 0 ? 1 : -1;
+				++features;
+			}
+
+			void add_tag(const tag_kind kind, const std::string & id)
+			{
+				const std::uint64_t h = mix(hash_bytes(id.data(), id.size()) + static_cast<std::uint64_t>(kind));
+				structure = (structure ^ h) * 1099511628211ull;
+				recent[tags % shingle_size] = h;
+				++tags;
+				if (tags < shingle_size) return;
+
+				// the oldest tag comes first
+				std::uint64_t shingle = 0;
+				for (std::size_t i = 0; i < shingle_size; ++i) shingle = mix(shingle ^ recent[(tags + i) % shingle_size]);
+				add_feature(shingle);
+			}
+
+			void add_text(const std::string & content)
+			{
+				std::size_t first = 0;
+				std::size_t last = content.size();
+				while (first != last && is_space(content[first])) ++first;
+				while (last != first && is_space(content[last - 1])) --last;
+				if (first == last) return;
+
+				std::uint64_t magnitude = 0;
+				for (std::size_t n = last - first; n != 0; n >>= 1) ++magnitude;
+				const std::uint64_t enclosing = tags != 0 ? recent[(tags - 1) % shingle_size] : 0;
+				add_feature(enclosing ^ mix(magnitude + 0x9e3779b97f4a7c15ull));
+			}
+
+		public:
+			fingerprint() {clear();}
+
+			/// @brief forgets all tokens, e.g. before the next document
+			void clear()
+			{
+				structure = 14695981039346656037ull;
+				for (std::int32_t & w : weights) w = 0;
+				for (std::uint64_t & r : recent) r = 0;
+				tags = 0;
+				features = 0;
+			}
+
+			/// @brief takes the next token of the document into account
+			/// @param token any token, kinds without structure are ignored
+			/// @details Suits the callback of parser::parse_all or a consumer of token_dispatcher, which then may
+			///			skip comments, CDATA sections and processing instructions.
+			void add(const tag_token & token)
+			{
+				if (token.is_type<open_tag>()) add_tag(tag_kind::open_tag, token.get<open_tag>().get_id());
+				else if (token.is_type<closing_tag>()) add_tag(tag_kind::closing_tag, token.get<closing_tag>().get_id());
+				else if (token.is_type<empty_tag>()) add_tag(tag_kind::empty_tag, token.get<empty_tag>().get_id());
+				else if (token.is_type<text>()) add_text(token.get<text>().get_content());
+			}
+
+			/// @brief gives the hash of the sequence of tags, equal for documents sharing their skeleton
+			inline std::uint64_t get_structure_hash() const {return structure;}
+
+			/// @brief gives the SimHash over tag shingles and text runs, compare with get_distance
+			std::uint64_t get_simhash() const
+			{
+				std::uint64_t bits = 0;
+				for (unsigned i = 0; i < 64; ++i)
+					if (weights[i] > 0) bits |= std::uint64_t(1) << i;
+				return bits;
+			}
+
+			inline std::uint64_t count_tags() const {return tags;}
+			inline std::uint64_t count_features() const {return features;}
+	};
+
+}
+
+#endif
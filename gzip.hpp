@@ -0,0 +1,86 @@
+/// @file gzip.hpp
+/// @author Michael Koch
+/// @copyright CC BY 3.0
+/// @note needs zlib, link with -lz
+
+#ifndef __TAGSOUP_GZIP_HPP__
+#define __TAGSOUP_GZIP_HPP__
+
+#include <cstddef>
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <zlib.h>
+
+namespace ts
+{
+
+	/// @class gzip_source
+	/// @brief source inflating the gzip or zlib compressed document of another source
+	/// @tparam Source class with a method std::size_t read(char * buffer, std::size_t size)
+	/// @details Compressed bytes are read block by block into a buffer which is reused, and inflated straight into
+	///			the buffer of the caller, e.g. the window of parse_stream. So neither the compressed nor the inflated
+	///			document is ever held completely. Concatenated gzip members, as found in WARC files, are inflated one
+	///			after the other. Corrupt or truncated input ends the document early and marks the source as failed.
+	template <typename Source>
+	class gzip_source
+	{
+		private:
+			Source & source;
+			z_stream stream;
+			std::vector<unsigned char> raw;
+			bool exhausted;
+			bool complete;
+			bool broken;
+
+		public:
+			/// @param source source of the compressed document
+			/// @param block_size number of compressed bytes read at once
+			gzip_source(Source & source, const std::size_t block_size = 1 << 16) :
+				source(source), stream(), raw(std::max<std::size_t>(block_size, 1)), exhausted(false), complete(true), broken(false)
+			{
+				// 15 bits of window plus 32 for automatic detection of the gzip or zlib header
+				broken = inflateInit2(&stream, 15 + 32) != Z_OK;
+			}
+
+			gzip_source(const gzip_source &) = delete;
+			gzip_source& operator = (const gzip_source &) = delete;
+
+			~gzip_source() {inflateEnd(&stream);}
+
+			/// @brief tells whether the compressed document has been corrupt or truncated
+			inline bool failed() const {return broken;}
+
+			std::size_t read(char * buffer, const std::size_t wanted)
+			{
+				const uInt capacity = static_cast<uInt>(std::min<std::size_t>(wanted, std::numeric_limits<uInt>::max()));
+				stream.next_out = reinterpret_cast<Bytef*>(buffer);
+				stream.avail_out = capacity;
+				while (stream.avail_out == capacity && capacity != 0 && !broken)
+				{
+					if (stream.avail_in == 0 && !exhausted)
+					{
+						const std::size_t n = source.read(reinterpret_cast<char*>(raw.data()), raw.size());
+						if (n == 0) exhausted = true;
+						stream.next_in = raw.data();
+						stream.avail_in = static_cast<uInt>(n);
+					}
+					if (stream.avail_in == 0 && exhausted && complete) break;
+
+					const int result = inflate(&stream, Z_NO_FLUSH);
+					if (result == Z_STREAM_END)
+					{
+						// another member may follow
+						complete = true;
+						if (inflateReset(&stream) != Z_OK) broken = true;
+					}
+					else if (result == Z_OK) complete = false;
+					else if (result != Z_BUF_ERROR || exhausted) broken = true;
+				}
+				return capacity - stream.avail_out;
+			}
+	};
+
+}
+
+#endif
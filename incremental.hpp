@@ -0,0 +1,671 @@
+/// @file incremental.hpp
+/// @author Michael Koch
+/// @copyright CC BY 3.0
+
+#ifndef __TAGSOUP_INCREMENTAL_HPP__
+#define __TAGSOUP_INCREMENTAL_HPP__
+
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+#include <string>
+#include <vector>
+#include <memory>
+#include <iterator>
+#include <algorithm>
+#include <tagsoup/parser.hpp>
+#include <tagsoup/document.hpp>
+#include <tagsoup/ascii.hpp>
+
+namespace ts
+{
+
+	/// @struct token_splice
+	/// @brief tokens replaced by an edit
+	struct token_splice
+	{
+		/// index of the first replaced token
+		std::size_t first;
+
+		/// number of old tokens removed at \a first
+		std::size_t removed;
+
+		/// number of new tokens inserted at \a first
+		std::size_t inserted;
+	};
+
+	/// @class incremental_document
+	/// @brief document which keeps its tokens up to date while it is edited
+	/// @details Besides the tokens the document keeps the byte offset of each token and the context of the tokenizer
+	///			in front of it. An edit restarts tokenizing at the last token boundary which cannot have been influenced
+	///			by the edited bytes, and stops as soon as a new boundary behind the edit meets an old boundary with the
+	///			same context: from there on the tokenizer would see the same bytes in the same state, so the old tokens
+	///			are kept. A keystroke therefore costs a few tokens of scanning instead of the whole document.
+	///
+	///			Neither the tokens nor the bytes behind an edit are touched by it. Tokens are kept in blocks of about
+	///			\a block_size, whose offsets, lines and columns are relative to the start of their block; the start
+	///			of each block follows from the sizes of the blocks in front of it and is brought up to date lazily,
+	///			up to the block which is accessed next. Likewise the position in the description of an unknown_tag
+	///			is corrected when its block is accessed. The source is a gap buffer whose gap follows the edits: an edit
+	///			moves the bytes between the previous edit and itself, so typing at one place moves no bytes at all. Since the lazy updates happen on access, a document must
+	///			not be read by several threads at once, not even through const members.
+	class incremental_document
+	{
+		private:
+
+			/// @brief number of bytes behind its end the tokenizer may have looked at to finish a token
+			/// @details A text ends in front of '<' and the content of a raw text element ends in front of '</' id
+			///			followed by a delimiter, where id has at most eight bytes.
+			static const std::size_t lookahead = 16;
+
+			/// number of tokens per block; an edit splits a block of more than twice as many tokens
+			static const std::size_t block_size = 256;
+
+			/// least number of bytes the gap grows by
+			static const std::size_t gap_step = 4096;
+
+			/// @struct entry
+			/// @brief token with its position relative to the start of its block
+			struct entry
+			{
+				tag_token token;
+
+				/// context in front of the token
+				parser::context context;
+
+				std::size_t offset;
+
+				/// lines in front of the token within the block
+				std::size_t line;
+
+				/// column if \a line is not zero, otherwise the columns in front of the token within the block
+				std::size_t column;
+			};
+
+			/// @struct block
+			/// @brief consecutive tokens
+			struct block
+			{
+				std::vector<entry> entries;
+
+				/// position of the end of the last token relative to the start of the block, see entry
+				std::size_t end_offset = 0;
+				std::size_t end_line = 0;
+				std::size_t end_column = 0;
+
+				/// index of the first token and absolute position of the start, valid in front of \a valid
+				std::size_t first = 0;
+				std::size_t offset = 0;
+				std::size_t line = 1;
+				std::size_t column = 0;
+
+				/// start of the block the descriptions of its unknown_tag tokens have been written for
+				std::size_t described_line = 1;
+				std::size_t described_column = 0;
+			};
+
+			/// @struct cursor
+			/// @brief token given by its block and its index within the block, the index equals the size of the
+			///			last block behind the last token
+			struct cursor
+			{
+				std::size_t block;
+				std::size_t index;
+			};
+
+			parser tokenizer;
+
+			/// bytes of the document with the gap in between
+			std::string buffer;
+			std::size_t gap_start;
+			std::size_t gap_size;
+
+			std::vector<std::unique_ptr<block>> blocks;
+
+			/// number of tokens
+			std::size_t count;
+
+			/// number of leading blocks whose start is up to date
+			mutable std::size_t valid;
+
+			/// @brief gives a position relative to a base position in front of it
+			/// @param line line to relate, then the number of lines behind the base
+			/// @param column column to relate, then the number of columns behind the base if on the same line
+			/// @param base_line line of the base
+			/// @param base_column column of the base
+			static void relate(std::size_t & line, std::size_t & column, const std::size_t base_line, const std::size_t base_column)
+			{
+				if (line == base_line) column -= base_column;
+				line -= base_line;
+			}
+
+			/// @brief gives the position of a relative position, the reverse of relate
+			static void resolve(std::size_t & line, std::size_t & column, const std::size_t base_line, const std::size_t base_column)
+			{
+				if (line == 0) column += base_column;
+				line += base_line;
+			}
+
+			/// @brief moves a line and column behind an edit from the old to the new position of the edit's end
+			/// @param line line to move
+			/// @param column column to move
+			/// @param old_line line at the end of the edit before it
+			/// @param old_column column at the end of the edit before it
+			/// @param new_line line at the end of the edit after it
+			/// @param new_column column at the end of the edit after it
+			/// @details Only a column on the same line as the end of the edit moves, later lines keep their columns.
+			static void shift_position(std::size_t & line, std::size_t & column, const std::size_t old_line, const std::size_t old_column,
+					const std::size_t new_line, const std::size_t new_column)
+			{
+				relate(line, column, old_line, old_column);
+				resolve(line, column, new_line, new_column);
+			}
+
+			/// @brief moves the position an unknown_tag describes, i.e. its trailing " at line,column"
+			static void shift_error_position(tag_token & token, const std::size_t old_line, const std::size_t old_column,
+					const std::size_t new_line, const std::size_t new_column)
+			{
+				if (!token.is_type<unknown_tag>()) return;
+				const std::string & description = token.get<unknown_tag>().get_description();
+				const std::size_t at = description.rfind(" at ");
+				if (at == std::string::npos) return;
+				std::size_t line = 0;
+				std::size_t column = 0;
+				std::size_t i = at + 4;
+				const std::size_t line_start = i;
+				for (; i < description.size() && is_digit(description[i]); ++i) line = line * 10 + (description[i] - '0');
+				if (i == line_start || i == description.size() || description[i] != ',') return;
+				const std::size_t column_start = ++i;
+				for (; i < description.size() && is_digit(description[i]); ++i) column = column * 10 + (description[i] - '0');
+				if (i == column_start || i != description.size()) return;
+
+				shift_position(line, column, old_line, old_column, new_line, new_column);
+				const std::uint8_t flags = token.flags;
+				token = make_unknown_tag_token(description.substr(0, at) + " at " + std::to_string(line) + "," + std::to_string(column));
+				token.flags = flags;
+			}
+
+			inline std::size_t get_size() const {return buffer.size() - gap_size;}
+
+			/// @brief gives the address of a byte, which stays valid until the next edit
+			inline const char * get_byte(const std::size_t offset) const
+			{
+				return buffer.data() + (offset < gap_start ? offset : offset + gap_size);
+			}
+
+			/// @brief moves the gap in front of some byte
+			/// @param offset position of the byte
+			void move_gap(const std::size_t offset)
+			{
+				if (gap_size == 0 || offset == gap_start)
+				{
+					gap_start = offset;
+					return;
+				}
+				char * const data = &buffer[0];
+				if (offset < gap_start) std::copy_backward(data + offset, data + gap_start, data + gap_start + gap_size);
+				else std::copy(data + gap_start + gap_size, data + offset + gap_size, data + gap_start);
+				gap_start = offset;
+			}
+
+			/// @brief lets the gap take some bytes, growing it in proportion to the document if needed
+			/// @param wanted number of bytes
+			void reserve_gap(const std::size_t wanted)
+			{
+				if (gap_size >= wanted) return;
+				const std::size_t growth = wanted - gap_size + get_size() / 8 + gap_step;
+				buffer.insert(gap_start, growth, '\0');
+				gap_size += growth;
+			}
+
+			/// @brief brings the start of the blocks up to some block up to date
+			/// @param k index of the last block to update
+			void validate(const std::size_t k) const
+			{
+				for (; valid <= k; ++valid)
+				{
+					const block & previous = *blocks[valid - 1];
+					block & next = *blocks[valid];
+					next.first = previous.first + previous.entries.size();
+					next.offset = previous.offset + previous.end_offset;
+					next.line = previous.end_line;
+					next.column = previous.end_column;
+					resolve(next.line, next.column, previous.line, previous.column);
+				}
+			}
+
+			/// @brief corrects the positions unknown_tag tokens of a block describe after its start has moved
+			/// @param b valid block
+			void describe(block & b) const
+			{
+				if (b.described_line == b.line && b.described_column == b.column) return;
+				for (entry & e : b.entries) shift_error_position(e.token, b.described_line, b.described_column, b.line, b.column);
+				b.described_line = b.line;
+				b.described_column = b.column;
+			}
+
+			/// @brief finds the block holding a token or byte
+			/// @param value index of token or offset of byte, see \a bytes
+			/// @param bytes whether \a value is an offset
+			/// @return index of the valid block; the last block if \a value lies behind the document
+			std::size_t find_block(const std::size_t value, const bool bytes) const
+			{
+				auto start = [bytes](const block & b) {return bytes ? b.offset : b.first;};
+				std::size_t k = valid - 1;
+				if (value < start(*blocks[k]))
+				{
+					// blocks with an up to date start are bisected, the others are walked and thereby brought up to date
+					return std::upper_bound(blocks.begin(), blocks.begin() + k, value,
+						[&start](const std::size_t v, const std::unique_ptr<block> & b) {return v < start(*b);}) - blocks.begin() - 1;
+				}
+				while (k + 1 < blocks.size() && value >= start(*blocks[k]) + (bytes ? blocks[k]->end_offset : blocks[k]->entries.size())) validate(++k);
+				return k;
+			}
+
+			/// @brief finds a token
+			/// @param i index of token, at most the number of tokens
+			cursor locate(const std::size_t i) const
+			{
+				const std::size_t k = find_block(i, false);
+				return cursor{k, i - blocks[k]->first};
+			}
+
+			/// @brief finds the token holding some byte
+			/// @param offset position of the byte, less than the size of the document
+			/// @return index of the token
+			std::size_t locate_byte(const std::size_t offset) const
+			{
+				const block & b = *blocks[find_block(offset, true)];
+				const auto i = std::upper_bound(b.entries.begin(), b.entries.end(), offset - b.offset,
+					[](const std::size_t relative, const entry & e) {return relative < e.offset;});
+				return b.first + (i - b.entries.begin()) - 1;
+			}
+
+			/// @brief gives the token behind another, within the valid blocks
+			void advance(cursor & c) const
+			{
+				++c.index;
+				if (c.index == blocks[c.block]->entries.size() && c.block + 1 < blocks.size())
+				{
+					validate(++c.block);
+					c.index = 0;
+				}
+			}
+
+			/// @brief gives the position in front of a token
+			/// @param c token, or the end of the last block
+			void get_position(const cursor c, std::size_t & offset, std::size_t & line, std::size_t & column) const
+			{
+				const block & b = *blocks[c.block];
+				if (c.index < b.entries.size())
+				{
+					offset = b.entries[c.index].offset;
+					line = b.entries[c.index].line;
+					column = b.entries[c.index].column;
+				}
+				else
+				{
+					offset = b.end_offset;
+					line = b.end_line;
+					column = b.end_column;
+				}
+				offset += b.offset;
+				resolve(line, column, b.line, b.column);
+			}
+
+			/// @brief turns runs of tokens into blocks behind some block, which end where that block has ended
+			/// @param k index of the block, whose start must be up to date
+			/// @param runs consecutive tokens, relative to the start of block \a k
+			void add_blocks(const std::size_t k, std::vector<std::vector<entry>> runs)
+			{
+				block & b = *blocks[k];
+				std::vector<std::unique_ptr<block>> added;
+				for (std::vector<entry> & run : runs)
+				{
+					// the start of each new block stays relative to block k until all of them are in place
+					std::unique_ptr<block> piece(new block());
+					piece->offset = run.front().offset;
+					piece->line = run.front().line;
+					piece->column = run.front().column;
+					for (entry & e : run)
+					{
+						e.offset -= piece->offset;
+						relate(e.line, e.column, piece->line, piece->column);
+					}
+					piece->entries.swap(run);
+					added.push_back(std::move(piece));
+				}
+
+				// each block ends where the next one starts
+				std::size_t end_offset = b.end_offset;
+				std::size_t end_line = b.end_line;
+				std::size_t end_column = b.end_column;
+				for (std::size_t p = added.size(); p != 0; --p)
+				{
+					block & piece = *added[p - 1];
+					piece.end_offset = end_offset - piece.offset;
+					piece.end_line = end_line;
+					piece.end_column = end_column;
+					relate(piece.end_line, piece.end_column, piece.line, piece.column);
+					end_offset = piece.offset;
+					end_line = piece.line;
+					end_column = piece.column;
+				}
+				b.end_offset = end_offset;
+				b.end_line = end_line;
+				b.end_column = end_column;
+
+				blocks.insert(blocks.begin() + k + 1, std::make_move_iterator(added.begin()), std::make_move_iterator(added.end()));
+				valid = k + 1;
+				validate(k + added.size());
+				for (std::size_t p = 1; p <= added.size(); ++p)
+				{
+					blocks[k + p]->described_line = blocks[k + p]->line;
+					blocks[k + p]->described_column = blocks[k + p]->column;
+				}
+			}
+
+			/// @brief moves the tokens of a block behind the first \a block_size into new blocks of \a block_size tokens
+			/// @param k index of the block to split, whose start must be up to date
+			void split(const std::size_t k)
+			{
+				std::vector<entry> & entries = blocks[k]->entries;
+				std::vector<std::vector<entry>> runs;
+				for (std::size_t first = block_size; first < entries.size(); first += block_size)
+					runs.emplace_back(std::make_move_iterator(entries.begin() + first), std::make_move_iterator(entries.begin() + std::min(first + block_size, entries.size())));
+				entries.erase(entries.begin() + block_size, entries.end());
+				add_blocks(k, std::move(runs));
+			}
+
+			/// @brief moves the tokens of the block behind another one into it
+			/// @param k index of the block to extend, whose start must be up to date
+			void merge(const std::size_t k)
+			{
+				block & b = *blocks[k];
+				validate(k + 1);
+				block & next = *blocks[k + 1];
+				describe(next);
+
+				// the start of the next block relative to this one
+				const std::size_t offset = next.offset - b.offset;
+				std::size_t line = next.line;
+				std::size_t column = next.column;
+				relate(line, column, b.line, b.column);
+				for (entry & e : next.entries)
+				{
+					e.offset += offset;
+					resolve(e.line, e.column, line, column);
+				}
+				b.entries.insert(b.entries.end(), std::make_move_iterator(next.entries.begin()), std::make_move_iterator(next.entries.end()));
+				b.end_offset = next.end_offset + offset;
+				b.end_line = next.end_line;
+				b.end_column = next.end_column;
+				resolve(b.end_line, b.end_column, line, column);
+				blocks.erase(blocks.begin() + k + 1);
+				valid = k + 1;
+			}
+
+			/// @brief moves pieces of tokens into the first one
+			static std::vector<entry>& join(std::vector<std::vector<entry>> & runs)
+			{
+				std::vector<entry> & run = runs.front();
+				for (std::size_t r = 1; r < runs.size(); ++r) run.insert(run.end(), std::make_move_iterator(runs[r].begin()), std::make_move_iterator(runs[r].end()));
+				return run;
+			}
+
+			/// @brief tokenizes again from some token on until the tokens meet the old ones
+			/// @param first index of the token to start with
+			/// @param changed_end first byte behind the inserted bytes, where the gap starts
+			/// @param erased number of bytes the edit has removed
+			/// @param inserted number of bytes the edit has inserted
+			/// @return replaced tokens
+			token_splice rescan(const std::size_t first, const std::size_t changed_end, const std::size_t erased, const std::size_t inserted)
+			{
+				const cursor from = locate(first);
+				block & target = *blocks[from.block];
+				describe(target);
+
+				// a long run of new tokens is kept in pieces of a block each, which can become blocks as they are
+				std::vector<std::vector<entry>> fresh(1);
+				std::size_t renewed = 0;
+				std::size_t position, line, column;
+				get_position(from, position, line, column);
+				parser::context current = from.index < target.entries.size() ? target.entries[from.index].context : parser::context();
+				cursor old = from;
+				const std::size_t size = get_size();
+				while (position != size)
+				{
+					if (position >= changed_end)
+					{
+						// old position of the same byte
+						const std::size_t old_position = position - inserted + erased;
+						std::size_t old_offset, old_line, old_column;
+						for (get_position(old, old_offset, old_line, old_column); old_offset < old_position && old.index < blocks[old.block]->entries.size();
+								get_position(old, old_offset, old_line, old_column)) advance(old);
+						if (old_offset == old_position && old.index < blocks[old.block]->entries.size() &&
+							blocks[old.block]->entries[old.index].context == current) break;
+					}
+
+					// the bytes in front of the gap may end within the lookahead of a token, then the gap moves on
+					std::size_t next_line = line;
+					std::size_t next_column = column;
+					parser::context next_context = current;
+					while (true)
+					{
+						const bool cut = gap_start != size;
+						if (!cut || position + lookahead < gap_start)
+						{
+							const char * start = buffer.data() + position;
+							next_line = line;
+							next_column = column;
+							next_context = current;
+							auto result = tokenizer.parse(start, buffer.data() + gap_start, next_line, next_column, next_context);
+							const char * next = std::get<0>(result);
+							if (!cut || (next != start && static_cast<std::size_t>(next - buffer.data()) + lookahead <= gap_start))
+							{
+								if (fresh.back().size() == block_size)
+								{
+									fresh.emplace_back();
+									fresh.back().reserve(block_size);
+								}
+								fresh.back().push_back(entry{std::move(std::get<1>(result)), current, position, line, column});
+								++renewed;
+
+								// an incomplete entity reaches up to the end of the document
+								position = next != start ? next - buffer.data() : size;
+								break;
+							}
+						}
+						move_gap(std::min(size, gap_start + std::max(static_cast<std::size_t>(gap_step), gap_start - position)));
+					}
+					line = next_line;
+					column = next_column;
+					current = next_context;
+				}
+				if (position == size)
+				{
+					validate(blocks.size() - 1);
+					old = cursor{blocks.size() - 1, blocks.back()->entries.size()};
+				}
+				move_gap(position);
+
+				// the old tokens from the meeting point on stay, moved from the old position of that point to the new one
+				block & source = *blocks[old.block];
+				describe(source);
+				std::size_t old_offset, old_line, old_column;
+				get_position(old, old_offset, old_line, old_column);
+				std::size_t removed = old.index - from.index;
+				for (std::size_t k = from.block; k != old.block; ++k) removed += blocks[k]->entries.size();
+				const token_splice splice{first, removed, renewed};
+
+				for (std::vector<entry> & run : fresh)
+					for (entry & e : run)
+					{
+						e.offset -= target.offset;
+						relate(e.line, e.column, target.line, target.column);
+					}
+				auto move_behind = [&](std::size_t & offset_in_block, std::size_t & line_in_block, std::size_t & column_in_block)
+				{
+					std::size_t offset_in_document = source.offset + offset_in_block + inserted - erased;
+					resolve(line_in_block, column_in_block, source.line, source.column);
+					shift_position(line_in_block, column_in_block, old_line, old_column, line, column);
+					relate(line_in_block, column_in_block, target.line, target.column);
+					offset_in_block = offset_in_document - target.offset;
+				};
+				for (std::size_t i = old.index; i < source.entries.size(); ++i)
+				{
+					entry & e = source.entries[i];
+					shift_error_position(e.token, old_line, old_column, line, column);
+					move_behind(e.offset, e.line, e.column);
+				}
+				move_behind(source.end_offset, source.end_line, source.end_column);
+				target.end_offset = source.end_offset;
+				target.end_line = source.end_line;
+				target.end_column = source.end_column;
+
+				std::vector<entry> & entries = target.entries;
+				count = count + renewed - removed;
+				valid = from.block + 1;
+				if (from.block == old.block && entries.empty())
+				{
+					// nothing is kept, e.g. when the document is tokenized for the first time
+					entries.swap(fresh.front());
+					fresh.erase(fresh.begin());
+					if (!fresh.empty()) add_blocks(from.block, std::move(fresh));
+				}
+				else if (from.block == old.block)
+				{
+					std::vector<entry> & run = join(fresh);
+
+					// replaces in place as far as possible
+					const std::size_t kept = std::min(removed, run.size());
+					std::move(run.begin(), run.begin() + kept, entries.begin() + from.index);
+					if (removed > kept) entries.erase(entries.begin() + from.index + kept, entries.begin() + old.index);
+					else entries.insert(entries.begin() + from.index + kept, std::make_move_iterator(run.begin() + kept), std::make_move_iterator(run.end()));
+				}
+				else
+				{
+					std::vector<entry> & run = join(fresh);
+					entries.erase(entries.begin() + from.index, entries.end());
+					entries.insert(entries.end(), std::make_move_iterator(run.begin()), std::make_move_iterator(run.end()));
+					entries.insert(entries.end(), std::make_move_iterator(source.entries.begin() + old.index), std::make_move_iterator(source.entries.end()));
+					blocks.erase(blocks.begin() + from.block + 1, blocks.begin() + old.block + 1);
+				}
+
+				if (entries.size() > 2 * block_size) split(from.block);
+				else if (from.block + 1 < blocks.size() && entries.size() + blocks[from.block + 1]->entries.size() <= block_size) merge(from.block);
+				else if (entries.empty() && from.block != 0 && from.block + 1 == blocks.size())
+				{
+					// only the last block can run empty, its start is the end of the document
+					blocks.pop_back();
+					valid = blocks.size();
+				}
+				return splice;
+			}
+
+		public:
+
+			/// @param tokenizer parser whose options are used for every edit
+			/// @param source document to tokenize
+			incremental_document(const parser & tokenizer, std::string source) :
+				tokenizer(tokenizer), buffer(std::move(source)), gap_start(buffer.size()), gap_size(0), count(0), valid(1)
+			{
+				blocks.emplace_back(new block());
+				rescan(0, buffer.size(), 0, buffer.size());
+			}
+
+			inline std::size_t size() const {return count;}
+			inline bool empty() const {return count == 0;}
+
+			/// @brief gives the whole document
+			/// @return copy of the bytes on both sides of the gap
+			std::string get_source() const
+			{
+				std::string source(buffer, 0, gap_start);
+				source.append(buffer, gap_start + gap_size, std::string::npos);
+				return source;
+			}
+
+			const tag_token& get_token(const std::size_t i) const
+			{
+				const cursor c = locate(i);
+				describe(*blocks[c.block]);
+				return blocks[c.block]->entries[c.index].token;
+			}
+
+			/// @param i index of token, or the number of tokens for the size of the document
+			std::size_t get_offset(const std::size_t i) const
+			{
+				std::size_t offset, line, column;
+				get_position(locate(i), offset, line, column);
+				return offset;
+			}
+
+			inline std::size_t get_length(const std::size_t i) const {return get_offset(i + 1) - get_offset(i);}
+			inline const parser::context& get_context(const std::size_t i) const
+			{
+				const cursor c = locate(i);
+				return blocks[c.block]->entries[c.index].context;
+			}
+
+			std::size_t get_line(const std::size_t i) const
+			{
+				std::size_t offset, line, column;
+				get_position(locate(i), offset, line, column);
+				return line;
+			}
+
+			std::size_t get_column(const std::size_t i) const
+			{
+				std::size_t offset, line, column;
+				get_position(locate(i), offset, line, column);
+				return column;
+			}
+
+			/// @brief gives the source bytes of a token
+			/// @param i index of token
+			/// @return view onto the whole token, valid until the next edit
+			/// @note the gap lies between tokens, so each token is contiguous
+			inline document_view get_span(const std::size_t i) const
+			{
+				const std::size_t offset = get_offset(i);
+				return document_view{get_byte(offset), get_offset(i + 1) - offset};
+			}
+
+			/// @brief finds the token holding some byte
+			/// @param offset position of the byte, less than the size of the document
+			/// @return index of the token
+			std::size_t find_token(const std::size_t offset) const
+			{
+				assert(offset < get_size());
+				return locate_byte(offset);
+			}
+
+			/// @brief replaces some bytes of the document and updates the tokens
+			/// @param offset position of the first byte to replace
+			/// @param erased number of bytes to remove
+			/// @param inserted bytes to insert instead
+			/// @return tokens which have been replaced; all tokens behind them are kept with shifted offsets and positions
+			token_splice edit(const std::size_t offset, const std::size_t erased, const std::string & inserted)
+			{
+				assert(offset + erased <= get_size());
+
+				// the gap swallows the erased bytes and starts behind the inserted ones
+				move_gap(offset + erased);
+				gap_start = offset;
+				gap_size += erased;
+				reserve_gap(inserted.size());
+				std::copy(inserted.begin(), inserted.end(), &buffer[gap_start]);
+				gap_start += inserted.size();
+				gap_size -= inserted.size();
+
+				// a token which ends more than the lookahead in front of the edit cannot have seen it
+				const std::size_t safe = offset > lookahead ? offset - lookahead : 0;
+				const std::size_t first = count == 0 ? 0 : locate_byte(safe);
+				return rescan(first, offset + inserted.size(), erased, inserted.size());
+			}
+	};
+
+}
+
+#endif
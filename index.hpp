@@ -0,0 +1,213 @@
+/// @file index.hpp
+/// @author Michael Koch
+/// @copyright CC BY 3.0
+
+#ifndef __TAGSOUP_INDEX_HPP__
+#define __TAGSOUP_INDEX_HPP__
+
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+#include <string>
+#include <vector>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <tagsoup/parser.hpp>
+#include <tagsoup/tags.hpp>
+#include <tagsoup/ascii.hpp>
+
+namespace ts
+{
+
+	/// position of a token, i.e. its index in the sequence of tokens of a document
+	typedef std::uint32_t token_position;
+
+	/// @struct position_range
+	/// @brief ascending positions of the tokens matching a query
+	struct position_range
+	{
+		const token_position * first;
+		const token_position * last;
+
+		inline const token_position * begin() const {return first;}
+		inline const token_position * end() const {return last;}
+		inline std::size_t size() const {return last - first;}
+		inline bool empty() const {return first == last;}
+	};
+
+	/// @brief gives the positions contained by two ranges, e.g. of a tag id and an attribute name
+	/// @param a first range
+	/// @param b second range
+	/// @return ascending positions found in both ranges
+	inline std::vector<token_position> intersect(const position_range a, const position_range b)
+	{
+		std::vector<token_position> both;
+		std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(both));
+		return both;
+	}
+
+	/// @class token_index
+	/// @brief inverted index of the tags of one document for repeated queries
+	/// @details The index maps tag ids, attribute names, values of id attributes and the single classes of class
+	///			attributes onto the positions of the open and empty tags which carry them. Each map is held as a
+	///			sorted array of keys, an array of offsets and one array of all positions, which are ascending per key.
+	///			A query is a binary search over the keys and returns its positions without copying, so it costs
+	///			O(log keys + matches) instead of a scan over all tokens.
+	///
+	///			Tokens are added one by one while tokenizing, e.g. from the callback of parser::parse_all or as a
+	///			consumer of a token_dispatcher, and finish sorts everything once. Keys are compared exactly as the
+	///			tokens hold them, so tag ids and attribute names are lowered if the parser lowers them.
+	class token_index
+	{
+		private:
+			/// @class postings
+			/// @brief sorted map from keys onto ascending positions
+			class postings
+			{
+				private:
+					/// pairs collected before finish
+					std::vector<std::pair<std::string, token_position>> pending;
+
+					std::vector<std::string> keys;
+
+					/// index of the first position of each key, plus one final entry with the number of positions
+					std::vector<token_position> starts;
+
+					std::vector<token_position> positions;
+
+				public:
+					postings() : starts(1, 0) {}
+
+					inline void add(std::string key, const token_position p) {pending.emplace_back(std::move(key), p);}
+
+					void finish()
+					{
+						// pairs are added with ascending positions, so sorting keeps them ascending per key
+						std::sort(pending.begin(), pending.end());
+						keys.clear();
+						starts.assign(1, 0);
+						positions.clear();
+						positions.reserve(pending.size());
+						for (auto & entry : pending)
+						{
+							if (keys.empty() || keys.back() != entry.first)
+							{
+								if (!keys.empty()) starts.push_back(static_cast<token_position>(positions.size()));
+								keys.push_back(std::move(entry.first));
+							}
+							// e.g. class="a a"
+							else if (positions.back() == entry.second) continue;
+							positions.push_back(entry.second);
+						}
+						if (!keys.empty()) starts.push_back(static_cast<token_position>(positions.size()));
+						std::vector<std::pair<std::string, token_position>>().swap(pending);
+					}
+
+					position_range find(const std::string & key) const
+					{
+						auto i = std::lower_bound(keys.begin(), keys.end(), key);
+						if (i == keys.end() || *i != key) return position_range{nullptr, nullptr};
+						const std::size_t k = i - keys.begin();
+						return position_range{positions.data() + starts[k], positions.data() + starts[k + 1]};
+					}
+
+					inline std::size_t size() const {return keys.size();}
+					inline const std::vector<std::string>& get_keys() const {return keys;}
+			};
+
+			postings tags;
+			postings attributes;
+			postings ids;
+			postings classes;
+
+			/// number of tokens added so far
+			token_position count;
+			bool finished;
+
+			template <typename Tag>
+			void add_tag(const Tag & tag)
+			{
+				tags.add(tag.get_id(), count);
+				for (auto i = tag.cbegin_attributes(); i != tag.cend_attributes(); ++i)
+				{
+					attributes.add(i->first, count);
+					if (i->first == "id") ids.add(i->second, count);
+					else if (i->first == "class")
+					{
+						const std::string & value = i->second;
+						std::size_t j = 0;
+						while (j < value.size())
+						{
+							while (j < value.size() && is_space(value[j])) ++j;
+							const std::size_t name = j;
+							while (j < value.size() && !is_space(value[j])) ++j;
+							if (j != name) classes.add(value.substr(name, j - name), count);
+						}
+					}
+				}
+			}
+
+		public:
+			token_index() : count(0), finished(false) {}
+
+			/// @brief indexes all tokens of a document at once
+			/// @param tokens tokens in document order
+			explicit token_index(const std::vector<tag_token> & tokens) : count(0), finished(false)
+			{
+				for (const tag_token & token : tokens) add(token);
+				finish();
+			}
+
+			/// @brief indexes the next token of the document
+			/// @param token token at position size()
+			/// @pre finish has not been called yet
+			void add(const tag_token & token)
+			{
+				assert(!finished);
+				if (token.is_type<open_tag>()) add_tag(token.get<open_tag>());
+				else if (token.is_type<empty_tag>()) add_tag(token.get<empty_tag>());
+				++count;
+			}
+
+			/// @brief sorts the collected keys and positions, after which the index can be queried
+			void finish()
+			{
+				tags.finish();
+				attributes.finish();
+				ids.finish();
+				classes.finish();
+				finished = true;
+			}
+
+			/// @brief gives the number of tokens added
+			inline std::size_t size() const {return count;}
+			inline bool is_finished() const {return finished;}
+
+			/// @brief finds the open and empty tags with some id
+			/// @param id tag id, e.g. "meta"
+			/// @return ascending positions of the tags
+			inline position_range find_tag(const std::string & id) const {assert(finished); return tags.find(id);}
+
+			/// @brief finds the open and empty tags having some attribute
+			/// @param name attribute name, e.g. "rel"
+			/// @return ascending positions of the tags
+			inline position_range find_attribute(const std::string & name) const {assert(finished); return attributes.find(name);}
+
+			/// @brief finds the tags whose id attribute has some value
+			/// @param value value of the id attribute
+			/// @return ascending positions of the tags, usually just one
+			inline position_range find_id(const std::string & value) const {assert(finished); return ids.find(value);}
+
+			/// @brief finds the tags whose class attribute contains some class
+			/// @param name single class, i.e. one of the words of the class attribute
+			/// @return ascending positions of the tags
+			inline position_range find_class(const std::string & name) const {assert(finished); return classes.find(name);}
+
+			/// @brief gives the distinct tag ids, sorted
+			inline const std::vector<std::string>& get_tag_ids() const {return tags.get_keys();}
+	};
+
+}
+
+#endif
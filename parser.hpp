@@ -5,17 +5,57 @@
 #ifndef __TAGSOUP_PARSER_HPP__
 #define __TAGSOUP_PARSER_HPP__
 
-#include <cctype>
+#include <cstdint>
+#include <array>
 #include <cassert>
 #include <tuple>
 #include <string>
+#include <cstring>
+#include <iterator>
 #include <algorithm>
+#include <type_traits>
+#include <limits>
+#include <chrono>
 #include <tagsoup/tags.hpp>
+#include <tagsoup/ascii.hpp>
+#include <tagsoup/scan.hpp>
+#include <tagsoup/utf8.hpp>
 
 namespace ts
 {
 
-	
+	/// @struct raw_text
+	/// @brief elements whose content is handed over as one text token instead of being parsed as markup
+	/// @details The values are flags which can be combined and passed to parser::raw_text_elements.
+	struct raw_text
+	{
+		enum : std::uint16_t
+		{
+			none = 0,
+			script = 1 << 0,
+			style = 1 << 1,
+			textarea = 1 << 2,
+			title = 1 << 3,
+			xmp = 1 << 4,
+			iframe = 1 << 5,
+			noembed = 1 << 6,
+			noframes = 1 << 7,
+			noscript = 1 << 8,
+			all = (1 << 9) - 1
+		};
+
+		/// number of known raw text elements
+		static const std::size_t count = 9;
+
+		/// @brief gives the id of a raw text element
+		/// @param index number of the flag, i.e. 0 for script, 1 for style and so on
+		/// @return id in lower case
+		static const char * get_name(const std::size_t index)
+		{
+			static const char * const names[count] = {"script", "style", "textarea", "title", "xmp", "iframe", "noembed", "noframes", "noscript"};
+			return names[index];
+		}
+	};
 
 	/// @class parser
 	/// @brief parses tagged documents (it only consists of a tokenizer)
@@ -153,6 +193,11 @@ namespace ts
 			bool allowing_weak_single_quote_coding;
 			bool allowing_unquoted_attribute_value;
 			bool allowing_concated_attribute;
+			bool lowercasing_names = false;
+			std::uint16_t raw_text_mask = raw_text::none;
+			utf8_validation validating_utf8 = utf8_validation::none;
+			std::size_t payload_limit = std::numeric_limits<std::size_t>::max();
+			bool recovering_soup = false;
 
 			/// @brief test whether state is accepting or not
 			/// @retval true state is accepting
@@ -170,13 +215,39 @@ namespace ts
 						state == state_type::dtd;
 			}
 
+			/// @brief test whether an entity in some state can still turn out to be broken
+			/// @retval true some later byte may fail the entity
+			/// @retval false every byte up to the end of the entity is accepted
+			/// @param state state to test
+			/// @details Text and the bodies of comments, CDATA sections and processing instructions accept any byte, so
+			///			soup recovery never needs the bytes of such an entity.
+			inline bool may_break(const state_type state) const
+			{
+				switch (state)
+				{
+					case state_type::characters:
+					case state_type::open_abracket__exclamation_mark__bar__bar:
+					case state_type::open_abracket__exclamation_mark__bar__bar__bar:
+					case state_type::open_abracket__exclamation_mark__bar__bar__bar__bar:
+					case state_type::open_abracket__exclamation_mark__sbracket__big_c__big_d__big_a__big_t__big_a__open_sbracket:
+					case state_type::open_abracket__exclamation_mark__sbracket__big_c__big_d__big_a__big_t__big_a__open_sbracket__closed_sbracket:
+					case state_type::open_abracket__exclamation_mark__sbracket__big_c__big_d__big_a__big_t__big_a__open_sbracket__closed_sbracket__closed_sbracket:
+					case state_type::open_abracket__question_mark__name__space:
+					case state_type::open_abracket__question_mark__name__code:
+					case state_type::open_abracket__question_mark__name__code__question_mark:
+						return false;
+					default:
+						return !is_accepting_state(state);
+				}
+			}
+
 			inline bool is_open_abracket(const char c) const {return c == '<';}
 			inline bool is_closed_abracket(const char c) const {return c == '>';}
 			inline bool is_exclamation_mark(const char c) const {return c == '!';}
 			inline bool is_question_mark(const char c) const {return c == '?';}
 			inline bool is_slash(const char c) const {return c == '/';}
-			inline bool is_starting_name(const char c) const {return std::isalpha(c);}
-			inline bool is_name(const char c) const {return std::isalnum(c) || c == '.' || c == '-';}
+			inline bool is_starting_name(const char c) const {return ts::is_alpha(c);}
+			inline bool is_name(const char c) const {return ts::is_alnum(c) || c == '.' || c == '-';}
 			inline bool is_char(const char c) const {return true;}
 			inline bool is_bar(const char c) const {return c == '-';}
 			inline bool is_open_sbracket(const char c) const {return c == '[';}
@@ -185,11 +256,16 @@ namespace ts
 			inline bool is_big_d(const char c) const {return c == 'D';}
 			inline bool is_big_a(const char c) const {return c == 'A';}
 			inline bool is_big_t(const char c) const {return c == 'T';}
-			inline bool is_space(const char c) const {return std::isspace(c);}
+			inline bool is_space(const char c) const {return ts::is_space(c);}
 			inline bool is_assignment(const char c) const {return c== '=';}
 			inline bool is_double_quote(const char c) const {return c == '\"';}
 			inline bool is_single_quote(const char c) const {return c == '\'';}
-			inline bool is_unquoted_attribute_value(const char c) const {return !std::isspace(c) && c != '\"' && c != '\'' && c != '=' && c != '<' && c != '>' && c != 0x60;}
+			inline bool is_unquoted_attribute_value(const char c) const {return !ts::is_space(c) && c != '\"' && c != '\'' && c != '=' && c != '<' && c != '>' && c != 0x60;}
+
+			/// @brief gives byte to store for a tag or attribute name
+			/// @param c byte read
+			/// @return \a c, lowered if names are lowercased
+			inline char fold_name(const char c) const {return lowercasing_names ? to_lower(c) : c;}
 
 			inline char get_closed_sbracket() const {return ']';}
 			inline char get_bar() const {return '-';}
@@ -290,6 +366,637 @@ namespace ts
 					assert(false);
 			}
 
+		public:
+
+			/// number of states the tokenizer can be in
+			static const std::size_t state_count = static_cast<std::size_t>(state_type::dtd) + 1;
+
+			/// @class statistics
+			/// @brief hot path counters of the tokenizer
+			/// @details The parser only records into an attached instance if TAGSOUP_STATISTICS is defined before
+			///			including this file; otherwise the counting code is not compiled at all. An instance is not
+			///			synchronised, hence every thread should attach its own one and merge snapshots afterwards.
+			struct statistics
+			{
+				/// number of buckets of the attribute histogram; the last bucket takes all larger tags
+				static const std::size_t attribute_buckets = 17;
+
+				/// number of returned tokens per tag kind, without the unknown_tag of an incomplete entity
+				std::array<std::uint64_t, tag_kind_count> tokens;
+
+				/// number of consumed bytes per state the byte has been consumed in
+				std::array<std::uint64_t, state_count> bytes;
+
+				/// number of errors per state the error has happened in
+				std::array<std::uint64_t, state_count> errors;
+
+				/// number of calls reaching the end before some entity were parsed completely
+				std::uint64_t incomplete;
+
+				/// histogram of the number of attributes per open and empty tag
+				std::array<std::uint64_t, attribute_buckets> attributes;
+
+				/// number of bytes of the longest entity parsed so far
+				std::uint64_t longest_entity;
+
+				statistics() {reset();}
+
+				/// @brief sets all counters to zero
+				void reset()
+				{
+					tokens.fill(0);
+					bytes.fill(0);
+					errors.fill(0);
+					incomplete = 0;
+					attributes.fill(0);
+					longest_entity = 0;
+				}
+
+				/// @brief adds counters of another instance
+				/// @param other instance whose counters will be added
+				/// @return this reference
+				statistics& operator += (const statistics & other)
+				{
+					for (std::size_t i = 0; i < tokens.size(); ++i) tokens[i] += other.tokens[i];
+					for (std::size_t i = 0; i < bytes.size(); ++i) bytes[i] += other.bytes[i];
+					for (std::size_t i = 0; i < errors.size(); ++i) errors[i] += other.errors[i];
+					incomplete += other.incomplete;
+					for (std::size_t i = 0; i < attributes.size(); ++i) attributes[i] += other.attributes[i];
+					longest_entity = std::max(longest_entity, other.longest_entity);
+					return *this;
+				}
+
+				/// @brief gives name of a state
+				/// @param state index of the state
+				/// @return name of the state as written in the source
+				static const char * get_state_name(const std::size_t state)
+				{
+					static const char * const names[] = {
+							"initial",
+							"open_abracket",
+							"open_abracket__exclamation_mark",
+							"open_abracket__exclamation_mark__big_d",
+							"open_abracket__exclamation_mark__big_do",
+							"open_abracket__exclamation_mark__big_doc",
+							"open_abracket__exclamation_mark__big_doct",
+							"open_abracket__exclamation_mark__big_docty",
+							"open_abracket__exclamation_mark__big_doctyp",
+							"open_abracket__exclamation_mark__big_doctype",
+							"open_abracket__exclamation_mark__big_doctype__space",
+							"open_abracket__exclamation_mark__big_doctype__space__name",
+							"open_abracket__exclamation_mark__big_doctype__space__name__space",
+							"open_abracket__exclamation_mark__bar",
+							"open_abracket__exclamation_mark__bar__bar",
+							"open_abracket__exclamation_mark__bar__bar__bar",
+							"open_abracket__exclamation_mark__bar__bar__bar__bar",
+							"open_abracket__exclamation_mark__sbracket",
+							"open_abracket__exclamation_mark__sbracket__big_c",
+							"open_abracket__exclamation_mark__sbracket__big_c__big_d",
+							"open_abracket__exclamation_mark__sbracket__big_c__big_d__big_a",
+							"open_abracket__exclamation_mark__sbracket__big_c__big_d__big_a__big_t",
+							"open_abracket__exclamation_mark__sbracket__big_c__big_d__big_a__big_t__big_a",
+							"open_abracket__exclamation_mark__sbracket__big_c__big_d__big_a__big_t__big_a__open_sbracket",
+							"open_abracket__exclamation_mark__sbracket__big_c__big_d__big_a__big_t__big_a__open_sbracket__closed_sbracket",
+							"open_abracket__exclamation_mark__sbracket__big_c__big_d__big_a__big_t__big_a__open_sbracket__closed_sbracket__closed_sbracket",
+							"open_abracket__question_mark",
+							"open_abracket__question_mark__name",
+							"open_abracket__question_mark__name__space",
+							"open_abracket__question_mark__name__code",
+							"open_abracket__question_mark__name__code__question_mark",
+							"open_abracket__slash",
+							"open_abracket__slash__name",
+							"open_abracket__slash__name__space",
+							"open_abracket__name",
+							"open_abracket__name__slash",
+							"open_abracket__name__space",
+							"open_abracket__name__attrname",
+							"open_abracket__name__attrname__space",
+							"open_abracket__name__attrequal",
+							"open_abracket__name__dq",
+							"open_abracket__name__sq",
+							"open_abracket__name__uq",
+							"open_abracket__name__attrend",
+							"characters",
+							"open_tag",
+							"closed_tag",
+							"empty_tag",
+							"text",
+							"process_instruction",
+							"cdata",
+							"comment",
+							"dtd"
+					};
+					static_assert(sizeof(names) / sizeof(names[0]) == state_count, "list of state names is incomplete!");
+					return names[state];
+				}
+
+				/// @brief exports all non zero counters as flat name value pairs
+				/// @tparam Visitor callable with signature void(const std::string &, std::uint64_t)
+				/// @param visitor gets called once per counter
+				/// @details Names are dot separated, i.e. "tokens.open_tag", "bytes.characters", "errors.open_abracket",
+				///			"errors.incomplete", "attributes.3", "attributes.16+" and "longest_entity".
+				template <typename Visitor>
+				void visit(Visitor visitor) const
+				{
+					for (std::size_t i = 0; i < tokens.size(); ++i)
+						if (tokens[i] != 0) visitor(std::string("tokens.") + get_kind_name(static_cast<tag_kind>(i)), tokens[i]);
+					for (std::size_t i = 0; i < bytes.size(); ++i)
+						if (bytes[i] != 0) visitor(std::string("bytes.") + get_state_name(i), bytes[i]);
+					for (std::size_t i = 0; i < errors.size(); ++i)
+						if (errors[i] != 0) visitor(std::string("errors.") + get_state_name(i), errors[i]);
+					if (incomplete != 0) visitor(std::string("errors.incomplete"), incomplete);
+					for (std::size_t i = 0; i < attributes.size(); ++i)
+						if (attributes[i] != 0)
+							visitor(std::string("attributes.") + std::to_string(i) + (i + 1 == attributes.size() ? "+" : ""), attributes[i]);
+					visitor(std::string("longest_entity"), longest_entity);
+				}
+			};
+
+			/// @struct context
+			/// @brief what the tokenizer expects at the start of the next token
+			/// @details Between two tokens the tokenizer is in its initial state, apart from the content of raw text
+			///			elements and comments or CDATA sections cut into chunks. The caller keeps the context across calls
+			///			of parse, see parse_all.
+			struct context
+			{
+				/// entities whose payload may be continued by the next token, see max_payload_size
+				enum class continuation : std::uint8_t
+				{
+					none = 0,
+					comment,
+					cdata
+				};
+
+				/// one plus the index of the raw text element whose content comes next, zero for markup
+				std::uint8_t raw_text = 0;
+
+				/// entity whose payload the next token continues
+				continuation continued = continuation::none;
+
+				bool operator == (const context & other) const {return raw_text == other.raw_text && continued == other.continued;}
+				bool operator != (const context & other) const {return !(*this == other);}
+			};
+
+			/// @struct limits
+			/// @brief hard limits which bound memory and time spent on hostile documents
+			/// @details Every limit is unlimited by default. A text or raw text entity longer than \a max_entity_length
+			///			is cut into several tokens carrying tag_flag::truncated. Cuts fall between UTF-8 characters, so a
+			///			piece ends in front of a character which does not fit anymore; only a limit smaller than a single
+			///			character lets the piece grow by the rest of that character. Any other entity which is too long, a
+			///			name which is too long or a tag with too many attributes ends in an unknown_tag token right
+			///			where the limit is exceeded, and tokenizing continues after it. The document limits are applied
+			///			by the drivers (parse_all, parse_stream, token_table) through account: the document is cut off
+			///			with an unknown_tag token.
+			struct limits
+			{
+				/// maximum number of bytes of a single entity, at least one
+				std::size_t max_entity_length = std::numeric_limits<std::size_t>::max();
+
+				/// maximum number of bytes of a tag id, attribute name or pi target
+				std::size_t max_name_length = std::numeric_limits<std::size_t>::max();
+
+				/// maximum number of attributes of a single tag
+				std::size_t max_attributes = std::numeric_limits<std::size_t>::max();
+
+				/// maximum number of tokens of a document
+				std::size_t max_tokens = std::numeric_limits<std::size_t>::max();
+
+				/// @brief maximum number of open tags not yet closed
+				/// @note void and unclosed elements count as well, so this is an upper bound of the depth a tree
+				///		builder would see
+				std::size_t max_depth = std::numeric_limits<std::size_t>::max();
+
+				/// @brief tells whether a limit applies while tags are scanned
+				inline bool limits_tags() const
+				{
+					return max_name_length != std::numeric_limits<std::size_t>::max() || max_attributes != std::numeric_limits<std::size_t>::max();
+				}
+			};
+
+			/// @struct usage
+			/// @brief what a document has used up of the document limits so far, kept by the driver
+			struct usage
+			{
+				std::size_t tokens = 0;
+				std::size_t depth = 0;
+			};
+
+			/// @struct progress
+			/// @brief everything needed to resume a document parsed piece by piece, see parse_some
+			struct progress
+			{
+				size_t line = 1;
+				size_t column = 0;
+				context current;
+				usage used;
+
+				/// set once the document is done, i.e. parsed up to its end, up to an incomplete entity or up to a limit
+				bool finished = false;
+			};
+
+			/// @struct budget
+			/// @brief how much work a call of parse_some may do before it returns
+			/// @details Either limit may be given, or both; the call returns as soon as one is used up.
+			struct budget
+			{
+				/// number of bytes to tokenize
+				std::size_t bytes = std::numeric_limits<std::size_t>::max();
+
+				/// point in time to return by
+				std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+
+				budget() = default;
+				explicit budget(const std::size_t bytes) : bytes(bytes) {}
+				explicit budget(const std::chrono::steady_clock::time_point deadline) : deadline(deadline) {}
+			};
+
+		private:
+
+			limits bounds;
+
+			/// @brief finds the raw text element with a specific id amongst the enabled ones
+			/// @tparam ForwardIterator type concept forward iterator
+			/// @param first first byte of the id of an open tag
+			/// @param last first byte after the id
+			/// @return one plus the index of the element or zero if there is none
+			template <typename ForwardIterator>
+			std::uint8_t find_raw_text_element(const ForwardIterator first, const ForwardIterator last) const
+			{
+				const std::size_t size = std::distance(first, last);
+				for (std::size_t i = 0; i < raw_text::count; ++i)
+				{
+					const char * name = raw_text::get_name(i);
+					if ((raw_text_mask & (1u << i)) != 0 && std::strlen(name) == size &&
+							std::equal(first, last, name, [](const char a, const char b){return equals_ignoring_case(a, b);}))
+						return static_cast<std::uint8_t>(i + 1);
+				}
+				return 0;
+			}
+
+			/// @brief finds the end of the content of a raw text element, i.e. its closing tag
+			/// @tparam ForwardIterator type concept forward iterator
+			/// @param i first byte of the content
+			/// @param end first iterator after last position of text to parse
+			/// @param id id of the element in lower case
+			/// @return position of the '<' of the closing tag or \a end
+			template <typename ForwardIterator>
+			static ForwardIterator find_raw_text_end(ForwardIterator i, const ForwardIterator end, const char * id)
+			{
+				const std::size_t size = std::strlen(id);
+				while ((i = find_byte(i, end, '<')) != end)
+				{
+					ForwardIterator j = i;
+					if (++j != end && *j == '/')
+					{
+						++j;
+						std::size_t k = 0;
+						while (k < size && j != end && equals_ignoring_case(*j, id[k])) {++j; ++k;}
+						if (k == size && (j == end || ts::is_space(*j) || *j == '>' || *j == '/')) return i;
+					}
+					++i;
+				}
+				return end;
+			}
+
+			/// @brief skips the remainder of a tag after its id
+			/// @tparam ForwardIterator type concept forward iterator
+			/// @param i first byte after the id
+			/// @param end first iterator after last position of text to parse
+			/// @param self_closing set to whether the tag ends with '/>'
+			/// @return position after the closing '>' or \a end
+			/// @details Quotes only count after '=', so that quoted values may contain '>'.
+			template <typename ForwardIterator>
+			static ForwardIterator skip_tag_rest(ForwardIterator i, const ForwardIterator end, bool & self_closing)
+			{
+				bool after_assignment = false;
+				char previous = 0;
+				while (i != end)
+				{
+					const char c = *i;
+					if (c == '>')
+					{
+						self_closing = previous == '/';
+						return ++i;
+					}
+					else if ((c == '"' || c == '\'') && after_assignment)
+					{
+						i = find_byte(++i, end, c);
+						if (i == end) return end;
+						after_assignment = false;
+					}
+					else if (c == '=') after_assignment = true;
+					else if (!ts::is_space(c)) after_assignment = false;
+					previous = c;
+					++i;
+				}
+				return end;
+			}
+
+			/// @brief compares the id at the current position ignoring ASCII case
+			/// @tparam ForwardIterator type concept forward iterator
+			/// @param i first byte of the id; moved behind the compared id
+			/// @param end first iterator after last position of text to parse
+			/// @param id id to compare with
+			/// @retval true the id at \a i equals \a id and is followed by a space, '/', '>' or the end
+			/// @retval false otherwise
+			template <typename ForwardIterator>
+			static bool match_id(ForwardIterator & i, const ForwardIterator end, const std::string & id)
+			{
+				std::size_t k = 0;
+				while (k < id.size() && i != end && equals_ignoring_case(*i, id[k])) {++i; ++k;}
+				return k == id.size() && (i == end || ts::is_space(*i) || *i == '/' || *i == '>');
+			}
+
+			/// kinds of markup told apart by skip_markup
+			enum class markup_kind
+			{
+				other,
+				open_tag,
+				closing_tag
+			};
+
+			/// @brief jumps over the markup starting at some '<' without building a token
+			/// @tparam ForwardIterator type concept forward iterator
+			/// @param i position of '<'
+			/// @param end first iterator after last position of text to parse
+			/// @param id id to compare tags with
+			/// @param kind set to the kind of the markup
+			/// @param matching set to whether the id of the tag equals \a id ignoring ASCII case
+			/// @param self_closing set to whether the tag ends with '/>'
+			/// @return position after the markup or after the '<' if it does not start any markup
+			/// @details Comments, CDATA sections, processing instructions and quoted attribute values are jumped over as
+			///			a whole, and so is the content of an enabled raw text element unless its id equals \a id.
+			template <typename ForwardIterator>
+			ForwardIterator skip_markup(ForwardIterator i, const ForwardIterator end, const std::string & id, markup_kind & kind,
+					bool & matching, bool & self_closing) const
+			{
+				kind = markup_kind::other;
+				matching = false;
+				self_closing = false;
+
+				ForwardIterator j = i;
+				if (++j == end) return end;
+				if (*j == '!')
+				{
+					ForwardIterator k = j;
+					if (++k != end && *k == '-' && ++k != end && *k == '-') return find_sequence_end(++k, end, "-->", 3);
+					else if (k != end && *k == '[') return find_sequence_end(k, end, "]]>", 3);
+					else return find_sequence_end(k, end, ">", 1);
+				}
+				else if (*j == '?') return find_sequence_end(++j, end, "?>", 2);
+				else if (*j == '/')
+				{
+					kind = markup_kind::closing_tag;
+					matching = match_id(++j, end, id);
+					return skip_tag_rest(j, end, self_closing);
+				}
+				else if (ts::is_alpha(*j))
+				{
+					kind = markup_kind::open_tag;
+					ForwardIterator name = j;
+					matching = match_id(j, end, id);
+					while (j != end && !ts::is_space(*j) && *j != '/' && *j != '>') ++j;
+					i = skip_tag_rest(j, end, self_closing);
+					if (!matching && raw_text_mask != raw_text::none && !self_closing)
+					{
+						const std::uint8_t element = find_raw_text_element(name, j);
+						if (element != 0) i = find_raw_text_end(i, end, raw_text::get_name(element - 1));
+					}
+					return i;
+				}
+				else return j;
+			}
+
+			/// @brief parse with context for forward iterators, handling content of raw text elements
+			template <typename ForwardIterator>
+			std::tuple<ForwardIterator, tag_token> parse(ForwardIterator start, ForwardIterator end, size_t & line, size_t & column,
+					context & current, const std::true_type) const
+			{
+				if (current.raw_text != 0)
+				{
+					const char * id = raw_text::get_name(current.raw_text - 1);
+					ForwardIterator body_end = end;
+					bool truncated = false;
+					const std::size_t cap = skipping_text ? bounds.max_entity_length : std::min(bounds.max_entity_length, payload_limit);
+					if (cap == std::numeric_limits<std::size_t>::max())
+						body_end = find_raw_text_end(start, end, id);
+					else
+					{
+						// the piece ends on a character boundary, so that it is valid UTF-8 on its own; a closing tag
+						// starting in front of the limit is found completely within the searched range
+						const ForwardIterator limit = align_utf8_cut(start, advance_at_most(start, end, cap), end);
+						const ForwardIterator search_end = advance_at_most(limit, end, std::strlen(id) + 3);
+						body_end = find_raw_text_end(start, search_end, id);
+						if (std::distance(start, body_end) > std::distance(start, limit))
+						{
+							body_end = limit;
+							truncated = true;
+						}
+					}
+					if (body_end != end && !truncated) current.raw_text = 0;
+					if (body_end != start)
+					{
+						std::string content;
+						if (!skipping_text) content.assign(start, body_end);
+						std::uint8_t flags = validating_utf8 != utf8_validation::none && check_utf8(content) ? tag_flag::invalid_utf8 : 0;
+						if (truncated) flags |= cap < bounds.max_entity_length ? tag_flag::partial : tag_flag::truncated;
+						advance_position(start, body_end, line, column);
+#ifdef TAGSOUP_STATISTICS
+						if (stats != nullptr)
+						{
+							const std::uint64_t consumed = std::distance(start, body_end);
+							stats->bytes[static_cast<std::size_t>(state_type::characters)] += consumed;
+							record(state_type::characters, false, consumed, 0);
+						}
+#endif
+						return mark(std::make_tuple(body_end, make_text_token(std::move(content))), flags);
+					}
+				}
+
+				auto result = scan(start, end, line, column, &current.continued);
+				if (raw_text_mask != raw_text::none && std::get<1>(result).template is_type<open_tag>())
+				{
+					const std::string & id = std::get<1>(result).template get<open_tag>().get_id();
+					current.raw_text = find_raw_text_element(id.cbegin(), id.cend());
+				}
+				return result;
+			}
+
+			/// @brief parse with context for input iterators; raw text elements need look ahead and are parsed as markup
+			template <typename InputIterator>
+			std::tuple<InputIterator, tag_token> parse(InputIterator start, InputIterator end, size_t & line, size_t & column,
+					context & current, const std::false_type) const
+			{
+				return scan(start, end, line, column, &current.continued);
+			}
+
+			/// @brief takes a run of text up to the next '<' at once
+			/// @tparam ContiguousIterator iterator whose bytes lie contiguously in memory
+			/// @param iter first byte of the run; gets advanced behind it
+			/// @param end first iterator after last position of text to parse
+			/// @param at_most maximum number of bytes to take
+			/// @param text payload to append to
+			/// @return number of bytes taken
+			/// @details The run is found by memchr and copied with a single append instead of byte by byte.
+			template <typename ContiguousIterator>
+			std::size_t scan_characters(ContiguousIterator & iter, const ContiguousIterator end, const std::size_t at_most, std::string & text,
+					size_t & line, size_t & column, const std::true_type) const
+			{
+				const ContiguousIterator limit = advance_at_most(iter, end, at_most);
+				ContiguousIterator run_end = find_byte(iter, limit, '<');
+				if (run_end == limit && limit != end && is_utf8_continuation(*limit))
+				{
+					// a run cut short must not split a character; if the character is all there is, the state machine
+					// takes it byte by byte
+					ContiguousIterator lead = limit;
+					std::size_t back = 0;
+					while (lead != iter && back < 3 && is_utf8_continuation(*lead)) {--lead; ++back;}
+					if (!is_utf8_continuation(*lead) && get_utf8_length(*lead) > back) run_end = lead;
+				}
+				const std::size_t run = run_end - iter;
+				if (!skipping_text) text.append(iter, run_end);
+				advance_position(iter, run_end, line, column);
+				iter = run_end;
+				return run;
+			}
+
+			/// @brief other iterators are read byte by byte by the state machine
+			template <typename InputIterator>
+			std::size_t scan_characters(InputIterator &, const InputIterator, const std::size_t, std::string &,
+					size_t &, size_t &, const std::false_type) const
+			{
+				return 0;
+			}
+
+			/// @brief gives the bytes of a broken entity, which soup recovery turns into text
+			/// @param text payload to assign
+			/// @param broken bytes recorded while scanning, needed by single pass iterators only
+			/// @param first first byte of the entity
+			/// @param last failing byte
+			template <typename ForwardIterator>
+			static void take_broken(std::string & text, std::string &, ForwardIterator first, const ForwardIterator last, const std::true_type)
+			{
+				text.assign(first, last);
+			}
+
+			template <typename InputIterator>
+			static void take_broken(std::string & text, std::string & broken, InputIterator, const InputIterator, const std::false_type)
+			{
+				text.swap(broken);
+			}
+
+			/// @brief tells whether a '<' can start markup, so that recovered text has to end in front of it
+			/// @param i position of the '<'
+			/// @param end first iterator after last position of text to parse
+			template <typename ForwardIterator>
+			bool may_start_markup(ForwardIterator i, const ForwardIterator end, const std::true_type) const
+			{
+				if (++i == end) return false;
+				const char c = *i;
+				return is_exclamation_mark(c) || is_question_mark(c) || is_slash(c) || is_starting_name(c);
+			}
+
+			/// @brief single pass iterators cannot look ahead, so every '<' may start markup
+			template <typename InputIterator>
+			bool may_start_markup(InputIterator, const InputIterator, const std::false_type) const
+			{
+				return true;
+			}
+
+			/// @brief checks the limits which apply while a tag is scanned
+			/// @param state current state
+			/// @param param1 id so far
+			/// @param param2 attribute name so far
+			/// @param pairs attributes so far
+			/// @return description of the exceeded limit or nullptr
+			const char * check_limits(const state_type state, const std::string & param1, const std::string & param2, const attribute_list & pairs) const
+			{
+				if (pairs.size() > bounds.max_attributes) return "tag exceeds attribute limit";
+				switch (state)
+				{
+					case state_type::open_abracket__name:
+					case state_type::open_abracket__slash__name:
+					case state_type::open_abracket__question_mark__name:
+						return param1.size() > bounds.max_name_length ? "name exceeds length limit" : nullptr;
+					case state_type::open_abracket__name__attrname:
+						return param2.size() > bounds.max_name_length ? "name exceeds length limit" : nullptr;
+					default:
+						return nullptr;
+				}
+			}
+
+			/// @brief checks a payload for ill formed UTF-8 as configured
+			/// @param payload string to check, gets repaired in replace mode
+			/// @retval true \a payload is or has been ill formed
+			/// @retval false \a payload is well formed
+			bool check_utf8(std::string & payload) const
+			{
+				if (validating_utf8 == utf8_validation::replace) return repair_utf8(payload);
+				else return !is_valid_utf8(payload);
+			}
+
+			/// @brief checks all payloads of a token for ill formed UTF-8
+			/// @return tag_flag::invalid_utf8 if some payload is ill formed, zero otherwise
+			std::uint8_t check_utf8(std::string & param1, std::string & param2, attribute_list & pairs) const
+			{
+				if (validating_utf8 == utf8_validation::none) return 0;
+				bool invalid = check_utf8(param1);
+				invalid = check_utf8(param2) || invalid;
+				for (auto & pair : pairs)
+				{
+					invalid = check_utf8(pair.first) || invalid;
+					invalid = check_utf8(pair.second) || invalid;
+				}
+				return invalid ? tag_flag::invalid_utf8 : 0;
+			}
+
+			/// @brief sets flags on the token of a result
+			/// @param result iterator and token as returned by parse
+			/// @param flags tag_flag bits to set
+			/// @return \a result
+			template <typename InputIterator>
+			static std::tuple<InputIterator, tag_token> mark(std::tuple<InputIterator, tag_token> && result, const std::uint8_t flags)
+			{
+				std::get<1>(result).flags |= flags;
+				return std::move(result);
+			}
+
+#ifdef TAGSOUP_STATISTICS
+			/// counters to record into, may be null
+			statistics * stats = nullptr;
+
+			/// @brief records a finished call of parse
+			/// @param state state the call has ended in
+			/// @param error whether the call has ended with an error
+			/// @param consumed number of bytes consumed by the call
+			/// @param attributes number of attributes of the parsed tag
+			void record(const state_type state, const bool error, const std::uint64_t consumed, const std::size_t attributes) const
+			{
+				tag_kind kind = tag_kind::unknown_tag;
+				if (error) ++stats->errors[static_cast<std::size_t>(state)];
+				else if (state == state_type::text || state == state_type::initial || state == state_type::characters) kind = tag_kind::text;
+				else if (state == state_type::open_tag) kind = tag_kind::open_tag;
+				else if (state == state_type::closed_tag) kind = tag_kind::closing_tag;
+				else if (state == state_type::empty_tag) kind = tag_kind::empty_tag;
+				else if (state == state_type::process_instruction) kind = tag_kind::pi;
+				else if (state == state_type::cdata) kind = tag_kind::cdata;
+				else if (state == state_type::dtd) kind = tag_kind::dtd;
+				else if (state == state_type::comment) kind = tag_kind::comment;
+				else
+				{
+					// the unknown_tag handed over for it is not counted as a token
+					++stats->incomplete;
+					stats->longest_entity = std::max(stats->longest_entity, consumed);
+					return;
+				}
+
+				++stats->tokens[static_cast<std::size_t>(kind)];
+				if (kind == tag_kind::open_tag || kind == tag_kind::empty_tag)
+					++stats->attributes[std::min(attributes, statistics::attribute_buckets - 1)];
+				stats->longest_entity = std::max(stats->longest_entity, consumed);
+			}
+#endif
+
 		public:
 
 			parser(const bool skipping_text = false, const bool skipping_cdata = false, const bool skipping_comment = false,
@@ -321,6 +1028,12 @@ namespace ts
 			inline bool allow_weak_single_quote_coding() const {return allowing_weak_single_quote_coding;}
 			inline bool allow_unquoted_attribute_value() const {return allowing_unquoted_attribute_value;}
 			inline bool allow_concated_attribute() const {return allowing_concated_attribute;}
+			inline bool lowercase_names() const {return lowercasing_names;}
+			inline std::uint16_t raw_text_elements() const {return raw_text_mask;}
+			inline utf8_validation validate_utf8() const {return validating_utf8;}
+			inline const limits& resource_limits() const {return bounds;}
+			inline std::size_t max_payload_size() const {return payload_limit;}
+			inline bool recover_soup() const {return recovering_soup;}
 
 			inline void skip_text(const bool skip) {skipping_text = skip;}
 			inline void skip_cdata(const bool skip) {skipping_cdata = skip;}
@@ -334,6 +1047,54 @@ namespace ts
 			inline void allow_unquoted_attribute_value(const bool allow) {allowing_unquoted_attribute_value = allow;}
 			inline void allow_concated_attribute(const bool allow) {allowing_concated_attribute = allow;}
 
+			/// @brief lets tag and attribute names be emitted in ASCII lower case
+			/// @param lowercase whether names should be lowered while they are scanned
+			/// @details Lowering happens on the fly, so consumers of HTML can compare ids without building lowered copies.
+			inline void lowercase_names(const bool lowercase) {lowercasing_names = lowercase;}
+
+			/// @brief selects elements whose content is handed over as one text token
+			/// @param elements combination of raw_text flags, e.g. raw_text::script | raw_text::style
+			/// @details After an open tag of a selected element, parse with context and parse_all search the matching
+			///			closing tag and return everything in front of it as a single text token, so script and style
+			///			bodies are never tokenized as markup. This needs forward iterators.
+			inline void raw_text_elements(const std::uint16_t elements) {raw_text_mask = elements;}
+
+			/// @brief lets the tokenizer check payloads for well formed UTF-8
+			/// @param mode whether ill formed tokens are only flagged or repaired as well
+			/// @details Every payload is checked right when its token is completed, while it is still in cache, with an
+			///			ASCII fast path that tests eight bytes at once. Consumers can rely on tag_flag::invalid_utf8
+			///			instead of scanning all strings again.
+			inline void validate_utf8(const utf8_validation mode) {validating_utf8 = mode;}
+
+			/// @brief bounds the resources a single document may use
+			/// @param l limits to apply, see limits
+			inline void resource_limits(const limits & l) {bounds = l;}
+
+			/// @brief cuts huge payloads into chunks of bounded size
+			/// @param size maximum number of payload bytes of a text, comment or CDATA token, at least one
+			/// @details Once the payload reaches \a size the token is handed over with tag_flag::partial and the next
+			///			token continues the same entity; its last chunk comes without the flag. A chunk ends in front of a
+			///			UTF-8 character which does not fit anymore, so every chunk can be validated on its own; only a size
+			///			smaller than one character lets a chunk grow by the rest of it. So a consumer can stream a
+			///			huge body through without holding it at once. Comments and CDATA sections are only chunked when
+			///			parsing with context, since the next call has to know it starts inside of them.
+			inline void max_payload_size(const std::size_t size) {payload_limit = size;}
+
+			/// @brief turns markup which cannot be tokenized into text instead of unknown_tag tokens
+			/// @param recover whether broken markup should be recovered
+			/// @details Where the state machine fails, the bytes of the entity read so far become text carrying
+			///			tag_flag::recovered, which goes on up to the next '<' that may start markup; with forward iterators
+			///			a '<' followed by anything but a name, '!', '?' or '/' stays in the text, single pass iterators end
+			///			the text at every '<'. No error description is built and every byte is read once, except for a
+			///			look at the byte after a '<', so the total work is linear in the input. Violated resource limits
+			///			and entities left incomplete at the end are reported as before.
+			inline void recover_soup(const bool recover) {recovering_soup = recover;}
+
+#ifdef TAGSOUP_STATISTICS
+			inline statistics * collect_statistics() const {return stats;}
+			inline void collect_statistics(statistics * s) {stats = s;}
+
+#endif
 			/// @brief parse incoming text for tag entities
 			/// @tparam InputIterator type concept input iterator
 			/// @return ...
@@ -341,20 +1102,117 @@ namespace ts
 			/// @param end first iterator after last position of text to parse
 			template <typename InputIterator>
 			std::tuple<InputIterator, tag_token> parse(InputIterator start, InputIterator end, size_t & line, size_t & column) const
+			{
+				return scan(start, end, line, column, nullptr);
+			}
+
+		private:
+
+			/// @brief runs the state machine for one token
+			/// @param continued entity the token continues, if any; gets set if the token is a chunk to be continued;
+			///			nullptr if comments and CDATA sections must not be chunked
+			/// @see parse
+			template <typename InputIterator>
+			std::tuple<InputIterator, tag_token> scan(InputIterator start, InputIterator end, size_t & line, size_t & column,
+					context::continuation * continued) const
 			{
 				static_assert(std::is_convertible<decltype(*start), char>::value, "iterator must refer to values of type char!");
 
 				state_type state = state_type::initial;
+				if (continued != nullptr && *continued == context::continuation::comment)
+					state = state_type::open_abracket__exclamation_mark__bar__bar;
+				else if (continued != nullptr && *continued == context::continuation::cdata)
+					state = state_type::open_abracket__exclamation_mark__sbracket__big_c__big_d__big_a__big_t__big_a__open_sbracket;
+				if (continued != nullptr) *continued = context::continuation::none;
 				std::string param1;
 				std::string param2;
 				std::string param3;
-				std::vector<std::pair<std::string, std::string>> pairs1;
+				attribute_list pairs1;
 
 				bool error = false;
+#ifdef TAGSOUP_STATISTICS
+				std::uint64_t consumed = 0;
+#endif
+				const bool limiting_tags = bounds.limits_tags();
+				const char * violated = nullptr;
+				bool truncated = false;
+				bool partial = false;
+				std::size_t length = 0;
+
+				// single pass iterators cannot go back to the start of a broken entity, so its bytes are recorded as long
+				// as it may still break
+				using category = typename std::iterator_traits<InputIterator>::iterator_category;
+				using forward = std::integral_constant<bool, std::is_base_of<std::forward_iterator_tag, category>::value>;
+				const bool recording = recovering_soup && !forward::value;
+				std::string broken;
+				bool recovered = false;
+
+				// payloads are never cut inside of a character: a piece ends in front of a sequence which does not fit
+				// anymore; \a pending counts the continuation bytes still expected, during which no cut is made
+				const bool cutting = bounds.max_entity_length != std::numeric_limits<std::size_t>::max() ||
+					payload_limit != std::numeric_limits<std::size_t>::max();
+				std::size_t pending = 0;
+
 				auto iter = start;
 				while (!is_accepting_state(state) && iter != end && !error)
 				{
+					std::size_t need = 1;
+					if (cutting && (state == state_type::characters || state == state_type::open_abracket__exclamation_mark__bar__bar ||
+							state == state_type::open_abracket__exclamation_mark__sbracket__big_c__big_d__big_a__big_t__big_a__open_sbracket))
+					{
+						// text ending right here needs no cut
+						const char next = *iter;
+						need = pending != 0 || (state == state_type::characters && is_open_abracket(next)) ? 0 : get_utf8_length(next);
+					}
+
+					if (state == state_type::characters ? need != 0 && length + need > bounds.max_entity_length : length == bounds.max_entity_length)
+					{
+						// text is cut into several tokens, any other entity this long is given up
+						if (state == state_type::characters) {state = state_type::text; truncated = true;}
+						else {error = true; violated = "entity exceeds length limit";}
+						break;
+					}
+
+					if (need != 0 && !param1.empty() && param1.size() + need > payload_limit)
+					{
+						// hand over a chunk, the next token continues the entity
+						if (state == state_type::characters) {state = state_type::text; partial = true; break;}
+						else if (continued != nullptr && state == state_type::open_abracket__exclamation_mark__bar__bar)
+						{
+							state = state_type::comment;
+							*continued = context::continuation::comment;
+							partial = true;
+							break;
+						}
+						else if (continued != nullptr && state == state_type::open_abracket__exclamation_mark__sbracket__big_c__big_d__big_a__big_t__big_a__open_sbracket)
+						{
+							state = state_type::cdata;
+							*continued = context::continuation::cdata;
+							partial = true;
+							break;
+						}
+					}
+
+					if (state == state_type::characters && pending == 0)
+					{
+						// a run of text is taken at once where the bytes lie contiguously in memory
+						const std::size_t entity_room = bounds.max_entity_length - std::min(bounds.max_entity_length, length);
+						const std::size_t room = skipping_text ? entity_room :
+							std::min(entity_room, payload_limit - std::min(payload_limit, param1.size()));
+						const std::size_t run = scan_characters(iter, end, room, param1, line, column,
+							std::integral_constant<bool, is_contiguous_iterator<InputIterator>::value>());
+						length += run;
+#ifdef TAGSOUP_STATISTICS
+						if (stats != nullptr) {stats->bytes[static_cast<std::size_t>(state_type::characters)] += run; consumed += run;}
+#endif
+						// a run ends on a character boundary
+						if (run != 0) {pending = 0; continue;}
+					}
+
 					auto c = *iter;
+#ifdef TAGSOUP_STATISTICS
+					const state_type consuming = state;
+#endif
 					switch (state)
 					{
 						// state so far is:
@@ -370,7 +1228,7 @@ namespace ts
 							if (is_exclamation_mark(c)) state = state_type::open_abracket__exclamation_mark;
 							else if (is_question_mark(c)) state = state_type::open_abracket__question_mark;
 							else if (is_slash(c)) state = state_type::open_abracket__slash;
-							else if (is_starting_name(c)) {param1.push_back(c); state = state_type::open_abracket__name;}
+							else if (is_starting_name(c)) {param1.push_back(fold_name(c)); state = state_type::open_abracket__name;}
 							else {error = true;}
 							break;
 
@@ -379,49 +1237,49 @@ namespace ts
 						case state_type::open_abracket__exclamation_mark:
 							if (is_bar(c)) state = state_type::open_abracket__exclamation_mark__bar;
 							else if (is_open_sbracket(c)) state = state_type::open_abracket__exclamation_mark__sbracket;
-							else if (c == 'D' || c == 'd') state = state_type::open_abracket__exclamation_mark__big_d;
+							else if (equals_ignoring_case(c, 'D')) state = state_type::open_abracket__exclamation_mark__big_d;
 							else {error = true;}
 							break;
 
 						// state so far is:
 						// '<!D'
 						case state_type::open_abracket__exclamation_mark__big_d:
-							if (c == 'O' || c == 'o') state = state_type::open_abracket__exclamation_mark__big_do;
+							if (equals_ignoring_case(c, 'O')) state = state_type::open_abracket__exclamation_mark__big_do;
 							else error = true;
 							break;
 
 						// state so far is:
 						// '<!DO'
 						case state_type::open_abracket__exclamation_mark__big_do:
-							if (c == 'C' || c == 'c') state = state_type::open_abracket__exclamation_mark__big_doc;
+							if (equals_ignoring_case(c, 'C')) state = state_type::open_abracket__exclamation_mark__big_doc;
 							else error = true;
 							break;
 
 						// state so far is:
 						// '<!DOC'
 						case state_type::open_abracket__exclamation_mark__big_doc:
-							if (c == 'T' || c == 't') state = state_type::open_abracket__exclamation_mark__big_doct;
+							if (equals_ignoring_case(c, 'T')) state = state_type::open_abracket__exclamation_mark__big_doct;
 							else error = true;
 							break;
 
 						// state so far is:
 						// '<!DOCT'
 						case state_type::open_abracket__exclamation_mark__big_doct:
-							if (c == 'Y' || c == 'y') state = state_type::open_abracket__exclamation_mark__big_docty;
+							if (equals_ignoring_case(c, 'Y')) state = state_type::open_abracket__exclamation_mark__big_docty;
 							else error = true;
 							break;
 
 						// state so far is:
 						// '<!DOCTY'
 						case state_type::open_abracket__exclamation_mark__big_docty:
-							if (c == 'P' || c == 'p') state = state_type::open_abracket__exclamation_mark__big_doctyp;
+							if (equals_ignoring_case(c, 'P')) state = state_type::open_abracket__exclamation_mark__big_doctyp;
 							else error = true;
 							break;
 
 						// state so far is:
 						// '<!DOCTYP'
 						case state_type::open_abracket__exclamation_mark__big_doctyp:
-							if (c == 'E' || c == 'e') state = state_type::open_abracket__exclamation_mark__big_doctype;
+							if (equals_ignoring_case(c, 'E')) state = state_type::open_abracket__exclamation_mark__big_doctype;
 							else error = true;
 							break;
 
@@ -543,8 +1401,8 @@ namespace ts
 								{
 									param1.push_back(get_bar());
 									param1.push_back(c);
-									state = state_type::open_abracket__exclamation_mark__bar__bar;
 								}
+								state = state_type::open_abracket__exclamation_mark__bar__bar;
 							}
 							else {error = true;}
 							break;
@@ -559,8 +1417,8 @@ namespace ts
 								{
 									param1.push_back(get_bar());
 									param1.push_back(c);
-									state = state_type::open_abracket__exclamation_mark__bar__bar;
 								}
+								state = state_type::open_abracket__exclamation_mark__bar__bar;
 							}
 							else {error = true;}
 							break;
@@ -588,11 +1446,8 @@ namespace ts
 							else if (is_question_mark(c)) {state = state_type::open_abracket__question_mark__name__code__question_mark;}
 							else if (is_char(c) || allowing_weak_pi_coding)
 							{
-								if (!skipping_pi)
-								{
-									param2.push_back(c);
-									state = state_type::open_abracket__question_mark__name__code;
-								}
+								if (!skipping_pi) param2.push_back(c);
+								state = state_type::open_abracket__question_mark__name__code;
 							}
 							else {error = true;}
 							break;
@@ -615,8 +1470,8 @@ namespace ts
 								{
 									param2.push_back(get_question_mark());
 									param2.push_back(c);
-									state = state_type::open_abracket__question_mark__name__code;
 								}
+								state = state_type::open_abracket__question_mark__name__code;
 							}
 							else {error = true;}
 							break;
@@ -624,7 +1479,7 @@ namespace ts
 						// state so far is:
 						// '</'
 						case state_type::open_abracket__slash:
-							if (is_starting_name(c)) {param1.push_back(c); state = state_type::open_abracket__slash__name;}
+							if (is_starting_name(c)) {param1.push_back(fold_name(c)); state = state_type::open_abracket__slash__name;}
 							else {error = true;}
 							break;
 
@@ -633,7 +1488,7 @@ namespace ts
 						case state_type::open_abracket__slash__name:
 							if (is_space(c)) {state = state_type::open_abracket__slash__name__space;}
 							else if (is_closed_abracket(c)) {state = state_type::closed_tag;}
-							else if (is_name(c)) {param1.push_back(c);}
+							else if (is_name(c)) {param1.push_back(fold_name(c));}
 							else {error = true;}
 							break;
 
@@ -650,7 +1505,7 @@ namespace ts
 							if (is_space(c)) {state = state_type::open_abracket__name__space;}
 							else if (is_closed_abracket(c)) {state = state_type::open_tag;}
 							else if (is_slash(c)) {state = state_type::open_abracket__name__slash;}
-							else if (is_name(c)) {param1.push_back(c);}
+							else if (is_name(c)) {param1.push_back(fold_name(c));}
 							else {error = true;}
 							break;
 
@@ -667,7 +1522,7 @@ namespace ts
 							if (is_space(c)) {}
 							else if (is_closed_abracket(c)) {state = state_type::open_tag;}
 							else if (is_slash(c)) {state = state_type::open_abracket__name__slash;}
-							else if (is_starting_name(c)) {param2.push_back(c); state = state_type::open_abracket__name__attrname;}
+							else if (is_starting_name(c)) {param2.push_back(fold_name(c)); state = state_type::open_abracket__name__attrname;}
 							else {error = true;}
 							break;
 
@@ -676,15 +1531,16 @@ namespace ts
 						case state_type::open_abracket__name__attrname:
 							if (is_space(c)) {state = state_type::open_abracket__name__attrname__space;}
 							else if (is_assignment(c)) {state = state_type::open_abracket__name__attrequal;}
-							else if (is_name(c)) {param2.push_back(c);}
-							else if (c == '>')
+							else if (is_name(c)) {param2.push_back(fold_name(c));}
+							else if (is_closed_abracket(c))
 							{
-								pairs1.push_back(std::make_pair(std::move(param1), std::string("")));
-								state = state_type::closed_tag;
+								pairs1.emplace_back(std::move(param2), std::string());
+								state = state_type::open_tag;
 							}
 							else if (is_slash(c))
 							{
-								pairs1.push_back(std::make_pair(std::move(param1), std::string("")));
+								pairs1.emplace_back(std::move(param2), std::string());
+								param2 = std::string();
 								state = state_type::open_abracket__name__slash;
 							}
 							else {error = true;}
@@ -696,20 +1552,21 @@ namespace ts
 							if (is_space(c)) {}
 							else if (is_starting_name(c))
 							{
-								pairs1.push_back(std::make_pair(std::move(param1), std::string("")));
-								param1 = std::string();
-								param1.push_back(c);
+								pairs1.emplace_back(std::move(param2), std::string());
+								param2 = std::string();
+								param2.push_back(fold_name(c));
 								state = state_type::open_abracket__name__attrname;
 							}
 							else if (is_assignment(c)) {state = state_type::open_abracket__name__attrequal;}
-							else if (c == '>')
+							else if (is_closed_abracket(c))
 							{
-								pairs1.push_back(std::make_pair(std::move(param1), std::string("")));
-								state = state_type::closed_tag;
+								pairs1.emplace_back(std::move(param2), std::string());
+								state = state_type::open_tag;
 							}
 							else if (is_slash(c))
 							{
-								pairs1.push_back(std::make_pair(std::move(param1), std::string("")));
+								pairs1.emplace_back(std::move(param2), std::string());
+								param2 = std::string();
 								state = state_type::open_abracket__name__slash;
 							}
 							else {error = true;}
@@ -750,19 +1607,19 @@ namespace ts
 						case state_type::open_abracket__name__uq:
 							if (is_space(c))
 							{
-								pairs1.push_back(std::make_pair(std::move(param2), std::move(param3)));
+								pairs1.emplace_back(std::move(param2), std::move(param3));
 								param2 = std::string();
 								param3 = std::string();
 								state = state_type::open_abracket__name__space;
 							}
 							else if (is_closed_abracket(c))
 							{
-								pairs1.push_back(std::make_pair(std::move(param2), std::move(param3)));
+								pairs1.emplace_back(std::move(param2), std::move(param3));
 								state = state_type::open_tag;
 							}
 							else if (is_slash(c))
 							{
-								pairs1.push_back(std::make_pair(std::move(param2), std::move(param3)));
+								pairs1.emplace_back(std::move(param2), std::move(param3));
 								param2 = std::string();
 								param3 = std::string();
 								state = state_type::open_abracket__name__slash;
@@ -774,7 +1631,7 @@ namespace ts
 						// state so far is:
 						// '<' Name (Space+ Attrname Space* '=' Space* AttrValue)* Space+ AttrName Space* '=' Space* AttrValue
 						case state_type::open_abracket__name__attrend:
-							pairs1.push_back(std::make_pair(std::move(param2), std::move(param3)));
+							pairs1.emplace_back(std::move(param2), std::move(param3));
 							param2 = std::string();
 							param3 = std::string();
 							if (is_space(c)) state = state_type::open_abracket__name__space;
@@ -782,7 +1639,7 @@ namespace ts
 							else if (is_closed_abracket(c)) state = state_type::open_tag;
 							else if (is_starting_name(c) && allowing_concated_attribute)
 							{
-								param2.push_back(c);
+								param2.push_back(fold_name(c));
 								state = state_type::open_abracket__name__attrname;
 							}
 							else {error = true;}
@@ -791,7 +1648,7 @@ namespace ts
 						// state so far is:
 						// (Char\{'<'})+
 						case state_type::characters:
-							if (is_open_abracket(c)) state = state_type::text;
+							if (is_open_abracket(c) && (!recovered || may_start_markup(iter, end, forward()))) state = state_type::text;
 							else if (!skipping_text) {param1.push_back(c);}
 							break;
 
@@ -799,29 +1656,268 @@ namespace ts
 							{assert(false);}
 					}
 
+					if (error && recovering_soup)
+					{
+#ifdef TAGSOUP_STATISTICS
+						if (stats != nullptr) ++stats->errors[static_cast<std::size_t>(state)];
+#endif
+						error = false;
+						recovered = true;
+						param2.clear();
+						param3.clear();
+						pairs1 = attribute_list();
+						if (skipping_text) param1.clear();
+						else take_broken(param1, broken, start, iter, forward());
+						if (is_open_abracket(c) && length != 0 && may_start_markup(iter, end, forward())) state = state_type::text;
+						else {if (!skipping_text) param1.push_back(c); state = state_type::characters;}
+					}
+
+					if (limiting_tags && (violated = check_limits(state, param1, param2, pairs1)) != nullptr) error = true;
+
 					if (c == '\n') {column = 0; ++line;}
 					else ++column;
 
 					// in case of text we don't go to the next position since
 					// we already have read some character necessary for reentering the loop
 					// so we must hold the position of the iterator
-					if (state != state_type::text) ++iter;
+					if (state != state_type::text)
+					{
+						if (recording)
+						{
+							if (may_break(state)) broken.push_back(c);
+							else broken.clear();
+						}
+						if (cutting) pending = is_utf8_continuation(c) ? (pending != 0 ? pending - 1 : 0) : get_utf8_length(c) - 1;
+						++iter;
+						++length;
+#ifdef TAGSOUP_STATISTICS
+						if (stats != nullptr) {++stats->bytes[static_cast<std::size_t>(consuming)]; ++consumed;}
+#endif
+					}
 				}
 
+#ifdef TAGSOUP_STATISTICS
+				if (stats != nullptr) record(state, error, consumed, pairs1.size());
+#endif
+
+				const std::uint8_t flags = error ? 0 : check_utf8(param1, param2, pairs1) | (truncated ? tag_flag::truncated : 0) | (partial ? tag_flag::partial : 0) |
+					(recovered ? tag_flag::recovered : 0);
 				if (error)
-					return std::make_tuple(iter, make_unknown_tag_token(formulate_error(state)+" at "+std::to_string(line)+","+std::to_string(column)));
+					return std::make_tuple(iter, make_unknown_tag_token((violated != nullptr ? std::string(violated) : formulate_error(state))+" at "+std::to_string(line)+","+std::to_string(column)));
 				else if (state == state_type::text || state == state_type::initial || state == state_type::characters)
-					return std::make_tuple(iter, make_text_token(std::move(param1)));
-				else if (state == state_type::open_tag) return std::make_tuple(iter, make_open_tag_token(std::move(param1), std::move(pairs1)));
-				else if (state == state_type::closed_tag) return std::make_tuple(iter, make_closing_tag_token(std::move(param1)));
-				else if (state == state_type::empty_tag) return std::make_tuple(iter, make_empty_tag_token(std::move(param1), std::move(pairs1)));
-				else if (state == state_type::process_instruction) return std::make_tuple(iter, make_pi_token(std::move(param1), std::move(param2)));
-				else if (state == state_type::cdata) return std::make_tuple(iter, make_cdata_token(std::move(param1)));
-				else if (state == state_type::dtd) return std::make_tuple(iter, make_dtd_token(std::move(param1)));
-				else if (state == state_type::comment) return std::make_tuple(iter, make_comment_token(std::move(param1)));
+					return mark(std::make_tuple(iter, make_text_token(std::move(param1))), flags);
+				else if (state == state_type::open_tag) return mark(std::make_tuple(iter, make_open_tag_token(std::move(param1), std::move(pairs1))), flags);
+				else if (state == state_type::closed_tag) return mark(std::make_tuple(iter, make_closing_tag_token(std::move(param1))), flags);
+				else if (state == state_type::empty_tag) return mark(std::make_tuple(iter, make_empty_tag_token(std::move(param1), std::move(pairs1))), flags);
+				else if (state == state_type::process_instruction) return mark(std::make_tuple(iter, make_pi_token(std::move(param1), std::move(param2))), flags);
+				else if (state == state_type::cdata) return mark(std::make_tuple(iter, make_cdata_token(std::move(param1))), flags);
+				else if (state == state_type::dtd) return mark(std::make_tuple(iter, make_dtd_token(std::move(param1))), flags);
+				else if (state == state_type::comment) return mark(std::make_tuple(iter, make_comment_token(std::move(param1))), flags);
 				else return std::make_tuple(start, make_unknown_tag_token(std::string("reached end before entity were acceptely parsed!")));
 			}
 
+		public:
+
+			/// @brief parse incoming text for tag entities, continuing from the context of the previous call
+			/// @tparam InputIterator type concept input iterator
+			/// @return position after the token and the token
+			/// @param start first iterator position of text to parse
+			/// @param end first iterator after last position of text to parse
+			/// @param current context left behind by the previous call, initially default constructed; gets updated
+			template <typename InputIterator>
+			std::tuple<InputIterator, tag_token> parse(InputIterator start, InputIterator end, size_t & line, size_t & column, context & current) const
+			{
+				using category = typename std::iterator_traits<InputIterator>::iterator_category;
+				return parse(start, end, line, column, current, std::integral_constant<bool, std::is_base_of<std::forward_iterator_tag, category>::value>());
+			}
+
+			/// @brief fast-forwards past the content and the closing tag of an element without building tokens
+			/// @tparam ForwardIterator type concept forward iterator
+			/// @return position after the closing tag of the element or \a end if it is not closed
+			/// @param start first byte after the open tag of the element
+			/// @param end first iterator after last position of text to parse
+			/// @param id id of the element, as given by the open tag
+			/// @param current context returned together with the open tag; gets reset to markup
+			/// @details The scanner only tracks the nesting depth of elements with the same id (ignoring ASCII case), so
+			///			unclosed or void elements inside do not matter. Comments, CDATA sections, processing instructions,
+			///			quoted attribute values and the content of enabled raw text elements are jumped over as a whole.
+			///			Everything else only costs a search for the next '<'.
+			template <typename ForwardIterator>
+			ForwardIterator skip_subtree(ForwardIterator start, const ForwardIterator end, const std::string & id,
+					size_t & line, size_t & column, context & current) const
+			{
+				const std::uint8_t raw = current.raw_text;
+				current.raw_text = 0;
+
+				ForwardIterator i = start;
+				std::size_t depth = 1;
+				if (raw != 0) i = find_raw_text_end(i, end, raw_text::get_name(raw - 1));
+				while ((i = find_byte(i, end, '<')) != end)
+				{
+					markup_kind kind;
+					bool matching;
+					bool self_closing;
+					i = skip_markup(i, end, id, kind, matching, self_closing);
+					if (matching && kind == markup_kind::closing_tag && --depth == 0) break;
+					else if (matching && kind == markup_kind::open_tag && !self_closing) ++depth;
+				}
+
+				advance_position(start, i, line, column);
+				return i;
+			}
+
+			/// @brief fast-forwards past the content and the closing tag of an element without building tokens
+			/// @see skip_subtree above; the content of raw text elements is not known without context
+			template <typename ForwardIterator>
+			ForwardIterator skip_subtree(ForwardIterator start, const ForwardIterator end, const std::string & id, size_t & line, size_t & column) const
+			{
+				context current;
+				return skip_subtree(start, end, id, line, column, current);
+			}
+
+			/// @brief applies the document limits to the next token a driver hands out
+			/// @param token token to hand out; replaced by an unknown_tag token if the document has to be cut off
+			/// @param used what the document has used up so far; gets updated
+			/// @retval true \a token may be handed out and the document goes on
+			/// @retval false \a token is the last one, the rest of the document must be dropped
+			bool account(tag_token & token, usage & used) const
+			{
+				if (used.tokens == bounds.max_tokens)
+				{
+					token = make_unknown_tag_token("document exceeds token limit of " + std::to_string(bounds.max_tokens));
+					return false;
+				}
+				++used.tokens;
+				if (token.is_type<open_tag>())
+				{
+					if (used.depth == bounds.max_depth)
+					{
+						token = make_unknown_tag_token("document exceeds depth limit of " + std::to_string(bounds.max_depth));
+						return false;
+					}
+					++used.depth;
+				}
+				else if (token.is_type<closing_tag>() && used.depth != 0) --used.depth;
+				return true;
+			}
+
+			/// @brief finds the next element with some id without building tokens
+			/// @tparam ForwardIterator type concept forward iterator
+			/// @return position of the '<' of its open tag and position after its closing tag, or \a end twice
+			/// @param start first iterator position of text to search, outside of any raw text element
+			/// @param end first iterator after last position of text to search
+			/// @param id id of the element, compared ignoring ASCII case
+			/// @details Markup is jumped over as in skip_subtree, so elements inside comments, CDATA sections or quoted
+			///			attribute values are not found. An element which is not closed reaches up to \a end.
+			template <typename ForwardIterator>
+			std::tuple<ForwardIterator, ForwardIterator> find_element(ForwardIterator start, const ForwardIterator end, const std::string & id) const
+			{
+				ForwardIterator i = start;
+				while ((i = find_byte(i, end, '<')) != end)
+				{
+					markup_kind kind;
+					bool matching;
+					bool self_closing;
+					const ForwardIterator next = skip_markup(i, end, id, kind, matching, self_closing);
+					if (matching && kind == markup_kind::open_tag)
+					{
+						if (self_closing) return std::make_tuple(i, next);
+						size_t line = 1;
+						size_t column = 0;
+						context current;
+						current.raw_text = find_raw_text_element(id.cbegin(), id.cend());
+						return std::make_tuple(i, skip_subtree(next, end, id, line, column, current));
+					}
+					i = next;
+				}
+				return std::make_tuple(end, end);
+			}
+
+			/// @brief parses a whole document token by token
+			/// @tparam InputIterator type concept input iterator
+			/// @tparam Callback callable with signature void(tag_token &&)
+			/// @return position where parsing has stopped, that is \a end or the start of an incomplete entity
+			/// @param start first iterator position of text to parse
+			/// @param end first iterator after last position of text to parse
+			/// @param callback gets every token in document order
+			/// @details An entity which cannot be completed before \a end is handed over as unknown_tag and ends parsing.
+			///			So does a document exceeding the token or depth limit, see limits; \a end is returned then.
+			template <typename InputIterator, typename Callback>
+			InputIterator parse_all(InputIterator start, InputIterator end, size_t & line, size_t & column, Callback callback) const
+			{
+				// single pass iterators compare equal as long as both are not at the end, hence only a forward
+				// iterator tells an incomplete entity; single pass input is exhausted by then anyway
+				using category = typename std::iterator_traits<InputIterator>::iterator_category;
+				const bool forward = std::is_base_of<std::forward_iterator_tag, category>::value;
+
+				context current;
+				usage used;
+				while (start != end)
+				{
+					auto result = parse(start, end, line, column, current);
+					const bool incomplete = forward && std::get<0>(result) == start;
+					if (!account(std::get<1>(result), used))
+					{
+						callback(std::move(std::get<1>(result)));
+						return end;
+					}
+					callback(std::move(std::get<1>(result)));
+					if (incomplete) break;
+					start = std::get<0>(result);
+				}
+				return start;
+			}
+
+			/// @brief parses a document token by token until a budget is used up
+			/// @tparam ForwardIterator type concept forward iterator
+			/// @tparam Callback callable with signature void(tag_token &&)
+			/// @return position to resume at; once \a state is finished, the position where parsing has stopped as
+			///			returned by parse_all, e.g. the start of an incomplete entity
+			/// @param start first iterator position of text to parse
+			/// @param end first iterator after last position of text to parse
+			/// @param state state of the document, initially default constructed; gets updated for the next call
+			/// @param limit work the call may do; at least one token is parsed anyway, so every call makes progress
+			/// @param callback gets every token in document order
+			/// @details Meant for event loops which must not be blocked by a huge document: the loop calls parse_some
+			///			with a small budget and resumes in a later round. Tokens end where they end, so a call may exceed
+			///			its byte budget by one token, which parser::limits::max_entity_length bounds. The clock is only read
+			///			every few tokens. Otherwise the tokens are the same as those of parse_all. Loop until
+			///			progress::finished is set, the returned position need not reach \a end.
+			template <typename ForwardIterator, typename Callback>
+			ForwardIterator parse_some(ForwardIterator start, const ForwardIterator end, progress & state, const budget & limit, Callback callback) const
+			{
+				const bool timed = limit.deadline != std::chrono::steady_clock::time_point::max();
+				std::size_t consumed = 0;
+				std::size_t count = 0;
+				while (start != end)
+				{
+					auto result = parse(start, end, state.line, state.column, state.current);
+					const ForwardIterator next = std::get<0>(result);
+					const bool admitted = account(std::get<1>(result), state.used);
+					callback(std::move(std::get<1>(result)));
+					// an incomplete entity and a document cut off at a limit are done
+					if (next == start || !admitted)
+					{
+						state.finished = true;
+						return admitted ? start : end;
+					}
+
+					consumed += std::distance(start, next);
+					start = next;
+					if (consumed >= limit.bytes) break;
+					if (timed && ++count % 16 == 0 && std::chrono::steady_clock::now() >= limit.deadline) break;
+				}
+				if (start == end) state.finished = true;
+				return start;
+			}
+
+			/// @brief reads raw content up to and including a closing tag whose id is accepted
+			/// @tparam InputIterator type concept input iterator
+			/// @tparam AcceptId predicate with signature bool(const std::string &), e.g. accept_id_ignoring_case
+			/// @return iterator after the closing tag and the content in front of it
+			/// @param begin first iterator position of text to parse
+			/// @param end first iterator after last position of text to parse
+			/// @param acceptId decides whether the id of a closing tag ends the content
 			template <typename InputIterator, typename AcceptId>
 			std::tuple<InputIterator, std::string> parse_until_closing_tag(InputIterator begin, InputIterator end, AcceptId acceptId, size_t & line, size_t & column)
 			{
@@ -0,0 +1,176 @@
+/// @file pipe.hpp
+/// @author Michael Koch
+/// @copyright CC BY 3.0
+
+#ifndef __TAGSOUP_PIPE_HPP__
+#define __TAGSOUP_PIPE_HPP__
+
+#include <cstddef>
+#include <cassert>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <type_traits>
+#include <tagsoup/parser.hpp>
+
+namespace ts
+{
+
+	/// @class token_pipe
+	/// @brief bounded lock free ring of tokens from one producer thread to one consumer thread
+	/// @details Each side keeps its own position and a cached copy of the position of the other side, which lives on
+	///			a cache line of its own. Positions are published in batches: the producer makes its tokens visible
+	///			every \a batch tokens and the consumer frees slots every \a batch tokens, so the cache lines only move
+	///			between the cores once per batch. Before a side waits it publishes what it has, hence neither side
+	///			can wait for a batch the other one holds back.
+	class token_pipe
+	{
+		private:
+			typedef typename std::aligned_storage<sizeof(tag_token), alignof(tag_token)>::type slot;
+
+			std::size_t capacity;
+			std::size_t mask;
+			std::size_t batch;
+			std::unique_ptr<slot[]> slots;
+
+			/// position the consumer reads next, as published to the producer
+			alignas(64) std::atomic<std::size_t> head;
+
+			/// position the producer writes next, as published to the consumer
+			alignas(64) std::atomic<std::size_t> tail;
+			std::atomic<bool> closed;
+
+			/// producer side
+			alignas(64) std::size_t write;
+			std::size_t cached_head;
+
+			/// consumer side
+			alignas(64) std::size_t read;
+			std::size_t cached_tail;
+
+			inline tag_token * get_slot(const std::size_t position) {return reinterpret_cast<tag_token*>(&slots[position & mask]);}
+
+		public:
+			/// @param capacity number of tokens the ring can hold, rounded up to a power of two
+			/// @param batch number of tokens published at once, at most \a capacity
+			token_pipe(const std::size_t capacity = 4096, const std::size_t batch = 64) :
+				capacity(1), head(0), tail(0), closed(false), write(0), cached_head(0), read(0), cached_tail(0)
+			{
+				while (this->capacity < capacity) this->capacity <<= 1;
+				mask = this->capacity - 1;
+				this->batch = batch == 0 ? 1 : (batch < this->capacity ? batch : this->capacity);
+				slots.reset(new slot[this->capacity]);
+			}
+
+			token_pipe(const token_pipe &) = delete;
+			token_pipe& operator = (const token_pipe &) = delete;
+
+			~token_pipe()
+			{
+				for (std::size_t i = read; i != write; ++i) get_slot(i)->~tag_token();
+			}
+
+			inline std::size_t get_capacity() const {return capacity;}
+
+			/// @brief makes all pushed tokens visible to the consumer
+			/// @note producer only
+			inline void flush() {tail.store(write, std::memory_order_release);}
+
+			/// @brief appends a token, waiting while the ring is full
+			/// @param token token to move into the ring
+			/// @note producer only
+			void push(tag_token && token)
+			{
+				if (write - cached_head == capacity)
+				{
+					cached_head = head.load(std::memory_order_acquire);
+					while (write - cached_head == capacity)
+					{
+						flush();
+						std::this_thread::yield();
+						cached_head = head.load(std::memory_order_acquire);
+					}
+				}
+				new (get_slot(write)) tag_token(std::move(token));
+				if (++write - tail.load(std::memory_order_relaxed) >= batch) flush();
+			}
+
+			/// @brief ends the stream of tokens and makes all pushed tokens visible
+			/// @note producer only
+			void close()
+			{
+				flush();
+				closed.store(true, std::memory_order_release);
+			}
+
+			/// @brief takes the next token, waiting while the ring is empty
+			/// @param token gets the next token; tag_token has no default constructor, so any token may serve as the
+			///			target, e.g. `tag_token token = make_text_token(std::string());`, or use consume
+			/// @retval true \a token has been assigned
+			/// @retval false the producer has closed the pipe and all tokens have been taken
+			/// @note consumer only
+			bool pop(tag_token & token)
+			{
+				if (read == cached_tail)
+				{
+					cached_tail = tail.load(std::memory_order_acquire);
+					while (read == cached_tail)
+					{
+						head.store(read, std::memory_order_release);
+						if (closed.load(std::memory_order_acquire))
+						{
+							// tokens published right before closing
+							cached_tail = tail.load(std::memory_order_acquire);
+							if (read == cached_tail) return false;
+							break;
+						}
+						std::this_thread::yield();
+						cached_tail = tail.load(std::memory_order_acquire);
+					}
+				}
+				tag_token * t = get_slot(read);
+				token = std::move(*t);
+				t->~tag_token();
+				if (++read - head.load(std::memory_order_relaxed) >= batch) head.store(read, std::memory_order_release);
+				return true;
+			}
+
+			/// @brief takes all tokens until the producer closes the pipe
+			/// @tparam Callback callable with signature void(tag_token &&)
+			/// @param callback gets every token in the order pushed
+			/// @note consumer only
+			template <typename Callback>
+			void consume(Callback callback)
+			{
+				tag_token token = make_text_token(std::string());
+				while (pop(token)) callback(std::move(token));
+			}
+
+			/// @brief tokenizes a document into the pipe and closes it
+			/// @tparam InputIterator type concept input iterator
+			/// @return position where parsing has stopped, see parser::parse_all
+			/// @param tokenizer parser to use
+			/// @param start first iterator position of text to parse
+			/// @param end first iterator after last position of text to parse
+			/// @note producer only; run it on a thread of its own while the consumer calls pop. The pipe is closed even
+			///			if tokenizing throws, so the consumer does not wait forever; the exception is passed on.
+			template <typename InputIterator>
+			InputIterator produce(const parser & tokenizer, InputIterator start, InputIterator end, size_t & line, size_t & column)
+			{
+				try
+				{
+					start = tokenizer.parse_all(start, end, line, column, [this](tag_token && token){push(std::move(token));});
+				}
+				catch (...)
+				{
+					close();
+					throw;
+				}
+				close();
+				return start;
+			}
+	};
+
+}
+
+#endif
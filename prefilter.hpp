@@ -0,0 +1,197 @@
+/// @file prefilter.hpp
+/// @author Michael Koch
+/// @copyright CC BY 3.0
+
+#ifndef __TAGSOUP_PREFILTER_HPP__
+#define __TAGSOUP_PREFILTER_HPP__
+
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+#include <tuple>
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <tagsoup/parser.hpp>
+#include <tagsoup/document.hpp>
+#include <tagsoup/ascii.hpp>
+#include <tagsoup/scan.hpp>
+
+namespace ts
+{
+
+	/// @class prefilter
+	/// @brief compiled set of literal patterns to reject documents or find the regions worth tokenizing
+	/// @details Patterns are compiled into a bitmap of their first two bytes, 64 Ki bits, plus a bitmap of the first
+	///			byte of one byte patterns. The scan costs one bit test per byte; only positions whose two bytes start
+	///			some pattern are verified against the patterns sharing them. If all patterns start with the same byte,
+	///			e.g. '<', the scan jumps from one occurrence of that byte to the next with memchr.
+	class prefilter
+	{
+		public:
+			/// value of the pattern index if nothing has been found
+			static const std::size_t npos = static_cast<std::size_t>(-1);
+
+		private:
+			std::vector<std::string> patterns;
+			bool ignoring_case;
+
+			/// bit per pair of first bytes of patterns with at least two bytes
+			std::vector<std::uint64_t> pairs;
+
+			/// bit per byte of one byte patterns
+			std::uint64_t singles[4];
+
+			/// pair of first bytes and index of each pattern, sorted
+			std::vector<std::pair<std::uint16_t, std::uint32_t>> starts;
+
+			/// byte all patterns start with, if there is exactly one, otherwise -1
+			int common_first;
+
+			inline unsigned char fold(const char c) const
+			{
+				return static_cast<unsigned char>(ignoring_case ? to_lower(c) : c);
+			}
+
+			inline static bool test(const std::uint64_t * bits, const std::size_t i) {return (bits[i >> 6] >> (i & 63)) & 1;}
+			inline static void set(std::uint64_t * bits, const std::size_t i) {bits[i >> 6] |= std::uint64_t(1) << (i & 63);}
+
+			/// @brief tests whether a pattern occurs at some position
+			bool verify(const std::string & pattern, const char * i, const char * last) const
+			{
+				if (static_cast<std::size_t>(last - i) < pattern.size()) return false;
+				if (!ignoring_case) return std::equal(pattern.begin(), pattern.end(), i);
+				return equals_ignoring_case(i, pattern.data(), pattern.size());
+			}
+
+		public:
+			/// @param patterns literal patterns, none of them empty
+			/// @param ignoring_case whether ASCII letters match regardless of their case
+			prefilter(std::vector<std::string> patterns, const bool ignoring_case = false) :
+				patterns(std::move(patterns)), ignoring_case(ignoring_case), pairs(1 << 10, 0), singles{0, 0, 0, 0}, common_first(-1)
+			{
+				for (std::size_t k = 0; k < this->patterns.size(); ++k)
+				{
+					const std::string & pattern = this->patterns[k];
+					assert(!pattern.empty());
+					const unsigned char first = fold(pattern[0]);
+					if (k == 0) common_first = first;
+					else if (common_first != first) common_first = -2;
+					if (pattern.size() == 1) set(singles, first);
+					else
+					{
+						const std::uint16_t pair = static_cast<std::uint16_t>(first << 8 | fold(pattern[1]));
+						set(pairs.data(), pair);
+						starts.emplace_back(pair, static_cast<std::uint32_t>(k));
+					}
+				}
+				std::sort(starts.begin(), starts.end());
+				// an ASCII letter may appear in two cases, which memchr cannot look for at once
+				if (common_first < 0 || (ignoring_case && is_alpha(static_cast<char>(common_first)))) common_first = -1;
+			}
+
+			inline std::size_t size() const {return patterns.size();}
+			inline const std::string& get_pattern(const std::size_t k) const {return patterns[k];}
+
+			/// @brief finds the first occurrence of any pattern
+			/// @param first first byte to search
+			/// @param last first byte after the range to search
+			/// @return position and index of the pattern, or \a last and npos
+			std::tuple<const char *, std::size_t> find(const char * first, const char * const last) const
+			{
+				const char * i = first;
+				while (i != last)
+				{
+					if (common_first >= 0)
+					{
+						i = find_byte(i, last, static_cast<char>(common_first));
+						if (i == last) break;
+					}
+					const unsigned char b0 = fold(*i);
+					if (test(singles, b0))
+					{
+						for (std::size_t k = 0; k < patterns.size(); ++k)
+							if (patterns[k].size() == 1 && fold(patterns[k][0]) == b0) return std::make_tuple(i, k);
+					}
+					if (i + 1 != last)
+					{
+						const std::uint16_t pair = static_cast<std::uint16_t>(b0 << 8 | fold(i[1]));
+						if (test(pairs.data(), pair))
+						{
+							auto range = std::equal_range(starts.begin(), starts.end(), std::make_pair(pair, std::uint32_t(0)),
+								[](const std::pair<std::uint16_t, std::uint32_t> & a, const std::pair<std::uint16_t, std::uint32_t> & b) {return a.first < b.first;});
+							for (auto j = range.first; j != range.second; ++j)
+								if (verify(patterns[j->second], i, last)) return std::make_tuple(i, static_cast<std::size_t>(j->second));
+						}
+					}
+					++i;
+				}
+				return std::make_tuple(last, static_cast<std::size_t>(npos));
+			}
+
+			/// @brief tells whether a document contains any pattern, so that it is worth tokenizing
+			/// @param document document to search
+			inline bool matches(const document_view document) const
+			{
+				return std::get<1>(find(document.begin(), document.end())) != npos;
+			}
+
+			/// @brief tokenizes only the regions of a document around occurrences of the patterns
+			/// @tparam Callback callable with signature void(std::size_t, tag_token &&)
+			/// @param tokenizer parser to use
+			/// @param document document to search
+			/// @param callback gets the index of the pattern which has led to the region and each token of the region
+			/// @details A region starts at the nearest '<' in front of an occurrence, where the tokenizer resumes in its
+			///			initial context, and ends with the token holding the end of the occurrence. If that token opens a
+			///			raw text element, like the script of `application/ld+json`, the content and the closing tag
+			///			follow as well; within regions all raw text elements are recognised, whatever
+			///			parser::raw_text_elements says. Searching goes on behind the region, so every byte is scanned
+			///			once by the patterns; lines are counted over the skipped bytes by memchr, so that positions in
+			///			error descriptions refer to the whole document.
+			template <typename Callback>
+			void parse_regions(const parser & tokenizer, const document_view document, Callback callback) const
+			{
+				parser scanner(tokenizer);
+				scanner.raw_text_elements(raw_text::all);
+
+				const char * const end = document.end();
+				const char * parsed = document.begin();
+				const char * i = document.begin();
+				size_t line = 1;
+				size_t column = 0;
+				while (i != end)
+				{
+					const char * found;
+					std::size_t k;
+					std::tie(found, k) = find(i, end);
+					if (k == npos) break;
+
+					// resynchronise at the nearest preceding '<' which has not been tokenized yet
+					const char * start = found;
+					while (start != parsed && *start != '<') --start;
+					if (*start != '<') start = found;
+
+					const char * const match_end = found + patterns[k].size();
+					advance_position(parsed, start, line, column);
+					parser::context current;
+					bool raw = false;
+					while (start != end && (start < match_end || raw))
+					{
+						const bool body = current.raw_text != 0;
+						auto result = scanner.parse(start, end, line, column, current);
+						const char * next = std::get<0>(result);
+						// the content of a raw text element is followed by its closing tag
+						raw = current.raw_text != 0 || (body && std::get<1>(result).is_type<text>());
+						callback(k, std::move(std::get<1>(result)));
+						start = next != start ? next : end;
+					}
+					parsed = start;
+					i = start;
+				}
+			}
+	};
+
+}
+
+#endif
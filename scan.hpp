@@ -0,0 +1,149 @@
+/// @file scan.hpp
+/// @author Michael Koch
+/// @copyright CC BY 3.0
+
+#ifndef __TAGSOUP_SCAN_HPP__
+#define __TAGSOUP_SCAN_HPP__
+
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <algorithm>
+#include <type_traits>
+#include <string>
+#include <vector>
+
+namespace ts
+{
+
+	/// @brief tells whether the bytes an iterator refers to lie contiguously in memory
+	/// @tparam Iterator iterator type
+	/// @details Pointers and the iterators of std::string and std::vector<char> are known to be contiguous, and with
+	///			C++20 every iterator satisfying std::contiguous_iterator. Such ranges are scanned in bulk, which takes
+	///			them as char; ranges of other value types, e.g. unsigned char, are scanned byte by byte.
+	template <typename Iterator>
+	struct is_contiguous_iterator : std::integral_constant<bool,
+		std::is_same<typename std::remove_cv<typename std::iterator_traits<Iterator>::value_type>::type, char>::value && (std::is_pointer<Iterator>::value ||
+		std::is_same<Iterator, std::string::iterator>::value || std::is_same<Iterator, std::string::const_iterator>::value ||
+		std::is_same<Iterator, std::vector<char>::iterator>::value || std::is_same<Iterator, std::vector<char>::const_iterator>::value
+#if __cplusplus >= 202002L
+		|| std::contiguous_iterator<Iterator>
+#endif
+		)>
+	{};
+
+	/// @brief finds the first occurrence of a byte in contiguous memory by means of memchr
+	/// @param first first position to search
+	/// @param last first position after the range to search
+	/// @param c byte to find
+	/// @return position of \a c or \a last
+	inline const char * find_byte(const char * first, const char * last, const char c)
+	{
+		const void * found = std::memchr(first, c, last - first);
+		return found != nullptr ? static_cast<const char*>(found) : last;
+	}
+
+	inline char * find_byte(char * first, char * last, const char c)
+	{
+		void * found = std::memchr(first, c, last - first);
+		return found != nullptr ? static_cast<char*>(found) : last;
+	}
+
+	/// @brief finds the first occurrence of a byte in a contiguous range other than a pointer range
+	template <typename ContiguousIterator>
+	inline ContiguousIterator find_byte(ContiguousIterator first, ContiguousIterator last, const char c, const std::true_type)
+	{
+		if (first == last) return last;
+		const char * p = &*first;
+		return first + (find_byte(p, p + (last - first), c) - p);
+	}
+
+	template <typename ForwardIterator>
+	inline ForwardIterator find_byte(ForwardIterator first, ForwardIterator last, const char c, const std::false_type)
+	{
+		return std::find(first, last, c);
+	}
+
+	/// @brief finds the first occurrence of a byte
+	/// @tparam ForwardIterator type concept forward iterator
+	/// @param first first position to search
+	/// @param last first position after the range to search
+	/// @param c byte to find
+	/// @return position of \a c or \a last
+	/// @details Contiguous ranges are searched by means of memchr as well.
+	template <typename ForwardIterator>
+	inline ForwardIterator find_byte(ForwardIterator first, ForwardIterator last, const char c)
+	{
+		return find_byte(first, last, c, std::integral_constant<bool, is_contiguous_iterator<ForwardIterator>::value>());
+	}
+
+	/// @brief finds the end of the first occurrence of a byte sequence
+	/// @tparam ForwardIterator type concept forward iterator
+	/// @param first first position to search
+	/// @param last first position after the range to search
+	/// @param sequence bytes to find
+	/// @param size number of bytes of \a sequence, at least one
+	/// @return position after the occurrence or \a last
+	template <typename ForwardIterator>
+	inline ForwardIterator find_sequence_end(ForwardIterator first, const ForwardIterator last, const char * sequence, const std::size_t size)
+	{
+		while ((first = find_byte(first, last, sequence[0])) != last)
+		{
+			ForwardIterator i = first;
+			++i;
+			std::size_t k = 1;
+			while (k < size && i != last && *i == sequence[k]) {++i; ++k;}
+			if (k == size) return i;
+			if (i == last) return last;
+			++first;
+		}
+		return last;
+	}
+
+	/// @brief advances an iterator by some bytes, but not beyond the end of its range
+	/// @tparam ForwardIterator type concept forward iterator
+	/// @param first first position of the range
+	/// @param last first position after the range
+	/// @param n maximum number of bytes to advance
+	/// @return position \a n bytes after \a first or \a last, whichever comes first
+	template <typename ForwardIterator>
+	inline ForwardIterator advance_at_most(ForwardIterator first, const ForwardIterator last, std::size_t n)
+	{
+		using category = typename std::iterator_traits<ForwardIterator>::iterator_category;
+		if (std::is_base_of<std::random_access_iterator_tag, category>::value)
+		{
+			const std::size_t available = std::distance(first, last);
+			std::advance(first, std::min(n, available));
+			return first;
+		}
+		while (n != 0 && first != last) {++first; --n;}
+		return first;
+	}
+
+	/// @brief updates line and column as if all bytes of a range had been read one by one
+	/// @tparam ForwardIterator type concept forward iterator
+	/// @param first first position of the range
+	/// @param last first position after the range
+	/// @param line line counter to update
+	/// @param column column counter to update
+	template <typename ForwardIterator>
+	inline void advance_position(ForwardIterator first, const ForwardIterator last, size_t & line, size_t & column)
+	{
+		while (first != last)
+		{
+			const ForwardIterator newline = find_byte(first, last, '\n');
+			if (newline == last)
+			{
+				column += std::distance(first, last);
+				return;
+			}
+			++line;
+			column = 0;
+			first = newline;
+			++first;
+		}
+	}
+
+}
+
+#endif
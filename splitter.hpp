@@ -0,0 +1,60 @@
+/// @file splitter.hpp
+/// @author Michael Koch
+/// @copyright CC BY 3.0
+
+#ifndef __TAGSOUP_SPLITTER_HPP__
+#define __TAGSOUP_SPLITTER_HPP__
+
+#include <cstddef>
+#include <tuple>
+#include <string>
+#include <vector>
+#include <tagsoup/parser.hpp>
+#include <tagsoup/document.hpp>
+#include <tagsoup/batch.hpp>
+
+namespace ts
+{
+
+	/// @brief finds the records of a dump, i.e. the outermost elements with some id
+	/// @param tokenizer parser whose raw text elements are taken into account
+	/// @param document whole dump
+	/// @param id id of the record element, e.g. "page", compared ignoring ASCII case
+	/// @return spans of all records in document order, each from the '<' of its open tag up to its closing tag
+	/// @details The scan builds no tokens: it only tracks the depth of record elements and jumps over comments,
+	///			CDATA sections, processing instructions and quoted attribute values, see parser::find_element.
+	///			Everything between the records, like the root element, is left out.
+	inline std::vector<document_view> split_records(const parser & tokenizer, const document_view document, const std::string & id)
+	{
+		std::vector<document_view> records;
+		const char * i = document.begin();
+		while (i != document.end())
+		{
+			const char * first;
+			const char * last;
+			std::tie(first, last) = tokenizer.find_element(i, document.end(), id);
+			if (first == document.end()) break;
+			records.push_back(document_view{first, static_cast<std::size_t>(last - first)});
+			i = last;
+		}
+		return records;
+	}
+
+	/// @brief splits a dump into records and tokenizes them on a thread pool
+	/// @tparam Callback callable with signature void(std::size_t, std::vector<tag_token> &)
+	/// @param pool thread pool, whose parser tokenizes the records
+	/// @param document whole dump, must stay alive until the call returns
+	/// @param id id of the record element
+	/// @param callback gets the index of the record and its tokens, see batch_tokenizer::tokenize
+	/// @return spans of all records, so that indices can be mapped back onto the dump
+	template <typename Callback>
+	std::vector<document_view> tokenize_records(const batch_tokenizer & pool, const document_view document, const std::string & id, Callback callback)
+	{
+		std::vector<document_view> records = split_records(pool.get_parser(), document, id);
+		pool.tokenize(records, callback);
+		return records;
+	}
+
+}
+
+#endif
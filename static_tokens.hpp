@@ -0,0 +1,303 @@
+/// @file static_tokens.hpp
+/// @author Michael Koch
+/// @copyright CC BY 3.0
+/// @note needs C++14 for constexpr functions with loops; empty otherwise
+
+#ifndef __TAGSOUP_STATIC_TOKENS_HPP__
+#define __TAGSOUP_STATIC_TOKENS_HPP__
+
+#include <cstdint>
+#include <cstddef>
+#include <tagsoup/tags.hpp>
+#include <tagsoup/ascii.hpp>
+#include <tagsoup/document.hpp>
+
+#if __cplusplus >= 201402L
+
+namespace ts
+{
+
+	/// @struct static_span
+	/// @brief bytes of a fragment given by offset and length
+	struct static_span
+	{
+		std::uint32_t offset = 0;
+		std::uint32_t length = 0;
+	};
+
+	/// @struct static_token
+	/// @brief token of a fragment tokenized at compile time
+	struct static_token
+	{
+		tag_kind kind = tag_kind::unknown_tag;
+
+		/// the whole token
+		static_span span;
+
+		/// id of tags, pi and dtd or content of text, comment and cdata, as in token_table
+		static_span value;
+
+		/// index of the first attribute in the attribute table and number of attributes
+		std::uint32_t first_attribute = 0;
+		std::uint32_t attribute_count = 0;
+	};
+
+	/// @struct static_attribute
+	/// @brief attribute of a tag tokenized at compile time, the value without quotes
+	struct static_attribute
+	{
+		static_span name;
+		static_span value;
+	};
+
+	/// @class static_token_table
+	/// @brief tokens of a fixed fragment, built by a constexpr scanner
+	/// @tparam N maximum number of tokens
+	/// @tparam A maximum number of attributes of all tags together
+	/// @details Meant for string literals known at compile time, e.g. templates: declared constexpr, the table is
+	///			computed by the compiler and lives in read only data, so nothing is parsed or allocated at startup.
+	///			Like token_table it holds spans into the fragment instead of strings; names are neither lowered nor
+	///			unescaped. The scanner accepts what the tokenizer accepts for well formed markup: texts, comments,
+	///			CDATA sections, doctypes, processing instructions and tags with quoted, unquoted or missing attribute
+	///			values, where an unquoted value ends at white space, '>' or a '/' behind its first byte. It differs
+	///			from the tokenizer for the rest: the content of raw text elements such as script is scanned as
+	///			markup, a '<' which starts none of them becomes an unknown_tag of two bytes and an entity left open
+	///			an unknown_tag up to the end, while the tokenizer ends an unknown_tag behind the failing byte. If
+	///			the fragment needs more than N tokens or A attributes the table is not complete, which a
+	///			static_assert should check.
+	template <std::size_t N, std::size_t A = N>
+	class static_token_table
+	{
+		static_assert(N > 0 && A > 0, "a table needs room for some tokens and attributes!");
+
+		private:
+			const char * source = nullptr;
+			std::size_t size = 0;
+			std::size_t count = 0;
+			std::size_t attribute_total = 0;
+			bool overflown = false;
+			static_token tokens[N] = {};
+			static_attribute attributes[A] = {};
+
+			static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+			constexpr bool starts_with(const std::size_t i, const char * sequence) const
+			{
+				std::size_t k = 0;
+				while (sequence[k] != 0)
+				{
+					if (i + k >= size || source[i + k] != sequence[k]) return false;
+					++k;
+				}
+				return true;
+			}
+
+			constexpr bool starts_with_ignoring_case(const std::size_t i, const char * sequence) const
+			{
+				std::size_t k = 0;
+				while (sequence[k] != 0)
+				{
+					if (i + k >= size || !equals_ignoring_case(source[i + k], sequence[k])) return false;
+					++k;
+				}
+				return true;
+			}
+
+			/// @return position of \a sequence at or after \a i or npos
+			constexpr std::size_t find(std::size_t i, const char * sequence) const
+			{
+				for (; i < size; ++i)
+					if (starts_with(i, sequence)) return i;
+				return npos;
+			}
+
+			constexpr std::size_t skip_spaces(std::size_t i) const
+			{
+				while (i < size && is_space(source[i])) ++i;
+				return i;
+			}
+
+			constexpr std::size_t skip_name(std::size_t i) const
+			{
+				while (i < size && !is_space(source[i]) && source[i] != '>' && source[i] != '/' && source[i] != '=') ++i;
+				return i;
+			}
+
+			constexpr void add(const tag_kind kind, const std::size_t first, const std::size_t last,
+					const std::size_t value_first, const std::size_t value_last, std::size_t first_attribute = npos)
+			{
+				if (count == N) {overflown = true; return;}
+				if (first_attribute == npos) first_attribute = attribute_total;
+				static_token & token = tokens[count++];
+				token.kind = kind;
+				token.span = static_span{static_cast<std::uint32_t>(first), static_cast<std::uint32_t>(last - first)};
+				token.value = static_span{static_cast<std::uint32_t>(value_first), static_cast<std::uint32_t>(value_last - value_first)};
+				token.first_attribute = static_cast<std::uint32_t>(first_attribute);
+				token.attribute_count = static_cast<std::uint32_t>(attribute_total - first_attribute);
+			}
+
+			constexpr void add_attribute(const std::size_t name, const std::size_t name_end, const std::size_t value, const std::size_t value_end)
+			{
+				if (attribute_total == A) {overflown = true; return;}
+				static_attribute & attribute = attributes[attribute_total++];
+				attribute.name = static_span{static_cast<std::uint32_t>(name), static_cast<std::uint32_t>(name_end - name)};
+				attribute.value = static_span{static_cast<std::uint32_t>(value), static_cast<std::uint32_t>(value_end - value)};
+			}
+
+			/// @brief scans an entity enclosed by an opening and a closing sequence
+			/// @return position after the entity
+			constexpr std::size_t add_enclosed(const tag_kind kind, const std::size_t i, const std::size_t opening, const char * closing, const std::size_t closing_size)
+			{
+				const std::size_t e = find(i + opening, closing);
+				if (e == npos) {add(tag_kind::unknown_tag, i, size, i, size); return size;}
+				std::size_t value = i + opening;
+				if (kind == tag_kind::dtd) value = skip_spaces(value);
+				add(kind, i, e + closing_size, value, e);
+				return e + closing_size;
+			}
+
+			/// @brief scans an open or empty tag
+			/// @return position after the tag
+			constexpr std::size_t add_tag(const std::size_t i)
+			{
+				const std::size_t name_end = skip_name(i + 1);
+				const std::size_t first_attribute = attribute_total;
+				std::size_t j = name_end;
+				while (true)
+				{
+					j = skip_spaces(j);
+					if (j >= size) break;
+					if (source[j] == '>')
+					{
+						add(tag_kind::open_tag, i, j + 1, i + 1, name_end, first_attribute);
+						return j + 1;
+					}
+					if (source[j] == '/')
+					{
+						if (j + 1 < size && source[j + 1] == '>')
+						{
+							add(tag_kind::empty_tag, i, j + 2, i + 1, name_end, first_attribute);
+							return j + 2;
+						}
+						break;
+					}
+
+					const std::size_t name = j;
+					j = skip_name(j);
+					if (j == name) break;
+					const std::size_t name_last = j;
+					std::size_t value = j;
+					std::size_t value_end = j;
+					const std::size_t after = skip_spaces(j);
+					if (after < size && source[after] == '=')
+					{
+						value = skip_spaces(after + 1);
+						if (value < size && (source[value] == '"' || source[value] == '\''))
+						{
+							const char quote = source[value++];
+							value_end = value;
+							while (value_end < size && source[value_end] != quote) ++value_end;
+							if (value_end == size) break;
+							j = value_end + 1;
+						}
+						else
+						{
+							// as in the tokenizer a '/' ends the value, e.g. <a href=x/>, unless it is the first byte
+							value_end = value < size && source[value] == '/' ? value + 1 : value;
+							while (value_end < size && !is_space(source[value_end]) && source[value_end] != '>' && source[value_end] != '/') ++value_end;
+							j = value_end;
+						}
+					}
+					add_attribute(name, name_last, value, value_end);
+				}
+				attribute_total = first_attribute;
+				add(tag_kind::unknown_tag, i, size, i, size);
+				return size;
+			}
+
+			constexpr void scan()
+			{
+				std::size_t i = 0;
+				while (i < size && !overflown)
+				{
+					if (source[i] != '<')
+					{
+						std::size_t j = i;
+						while (j < size && source[j] != '<') ++j;
+						add(tag_kind::text, i, j, i, j);
+						i = j;
+					}
+					else if (starts_with(i, "<!--")) i = add_enclosed(tag_kind::comment, i, 4, "-->", 3);
+					else if (starts_with(i, "<![CDATA[")) i = add_enclosed(tag_kind::cdata, i, 9, "]]>", 3);
+					else if (starts_with_ignoring_case(i, "<!DOCTYPE")) i = add_enclosed(tag_kind::dtd, i, 9, ">", 1);
+					else if (i + 2 < size && source[i + 1] == '?' && is_alpha(source[i + 2]))
+					{
+						const std::size_t e = find(i + 2, "?>");
+						if (e == npos) {add(tag_kind::unknown_tag, i, size, i, size); i = size; continue;}
+						std::size_t name_end = i + 2;
+						while (name_end < e && !is_space(source[name_end])) ++name_end;
+						add(tag_kind::pi, i, e + 2, i + 2, name_end);
+						i = e + 2;
+					}
+					else if (i + 2 < size && source[i + 1] == '/' && is_alpha(source[i + 2]))
+					{
+						const std::size_t name_end = skip_name(i + 2);
+						const std::size_t j = skip_spaces(name_end);
+						if (j < size && source[j] == '>') {add(tag_kind::closing_tag, i, j + 1, i + 2, name_end); i = j + 1;}
+						else {add(tag_kind::unknown_tag, i, size, i, size); i = size;}
+					}
+					else if (i + 1 < size && is_alpha(source[i + 1])) i = add_tag(i);
+					else
+					{
+						const std::size_t j = i + 2 < size ? i + 2 : size;
+						add(tag_kind::unknown_tag, i, j, i, j);
+						i = j;
+					}
+				}
+			}
+
+		public:
+			constexpr static_token_table() = default;
+
+			/// @brief tokenizes a fragment
+			/// @param source first byte of the fragment, which must outlive the table
+			/// @param size number of bytes of the fragment
+			constexpr static_token_table(const char * source, const std::size_t size) : source(source), size(size)
+			{
+				scan();
+			}
+
+			inline constexpr std::size_t get_size() const {return count;}
+
+			/// @brief tells whether the whole fragment has fit into the table
+			inline constexpr bool complete() const {return !overflown;}
+
+			inline constexpr const static_token& operator [] (const std::size_t i) const {return tokens[i];}
+			inline constexpr tag_kind get_kind(const std::size_t i) const {return tokens[i].kind;}
+			inline constexpr const static_attribute& get_attribute(const std::size_t i, const std::size_t j) const
+			{
+				return attributes[tokens[i].first_attribute + j];
+			}
+
+			/// @brief gives the bytes of a span
+			/// @param span span within the fragment
+			/// @return view onto the bytes
+			inline constexpr document_view get_view(const static_span span) const {return document_view{source + span.offset, span.length};}
+	};
+
+	/// @brief tokenizes a string literal at compile time
+	/// @tparam N maximum number of tokens
+	/// @tparam A maximum number of attributes
+	/// @param source string literal; its terminating zero is not part of the fragment
+	/// @return table of tokens, e.g. `constexpr auto table = ts::tokenize_static<16>("<p class='x'>hi</p>");`
+	template <std::size_t N, std::size_t A = N, std::size_t M>
+	constexpr static_token_table<N, A> tokenize_static(const char (&source)[M])
+	{
+		return static_token_table<N, A>(source, M - 1);
+	}
+
+}
+
+#endif
+
+#endif
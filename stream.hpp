@@ -0,0 +1,365 @@
+/// @file stream.hpp
+/// @author Michael Koch
+/// @copyright CC BY 3.0
+
+#ifndef __TAGSOUP_STREAM_HPP__
+#define __TAGSOUP_STREAM_HPP__
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <exception>
+#include <istream>
+#include <cerrno>
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+#include <tagsoup/parser.hpp>
+#include <tagsoup/encoding.hpp>
+
+namespace ts
+{
+
+	/// @brief tokenizes a document which is read block by block from a source
+	/// @tparam Source class with a method std::size_t read(char * buffer, std::size_t size) which copies at most
+	///			\a size bytes into \a buffer and returns their number, zero at the end of the document
+	/// @tparam Callback callable with signature void(tag_token &&)
+	/// @param tokenizer parser to use
+	/// @param source document to tokenize
+	/// @param callback gets every token in document order
+	/// @param block_size number of bytes requested from \a source at once
+	/// @details Only a window from the start of the current token up to the last byte read is kept. A token which
+	///			touches the end of the window might continue in the next block, so it is parsed again once more bytes
+	///			have arrived. While it stays unfinished each read asks for as many bytes as the window already holds,
+	///			so a token larger than a block is parsed a logarithmic number of times and in time linear in its size.
+	///			The window then holds up to about twice the token; parser::limits::max_entity_length ends a token
+	///			early and so bounds the window too. A document exceeding the token or depth limit is not read any
+	///			further.
+	template <typename Source, typename Callback>
+	void parse_stream(const parser & tokenizer, Source & source, Callback callback, const std::size_t block_size = 1 << 16)
+	{
+		std::vector<char> window(2 * block_size);
+		std::size_t first = 0;
+		std::size_t last = 0;
+		bool exhausted = false;
+		bool starving = true;
+
+		size_t line = 1;
+		size_t column = 0;
+		parser::context current;
+		parser::usage used;
+
+		while (true)
+		{
+			if (!exhausted && (starving || last - first < block_size))
+			{
+				if (first != 0)
+				{
+					std::memmove(window.data(), window.data() + first, last - first);
+					last -= first;
+					first = 0;
+				}
+				// an unfinished token is parsed again only after its bytes so far have doubled
+				const std::size_t wanted = starving ? std::max(block_size, last) : block_size;
+				if (window.size() - last < wanted) window.resize(last + wanted);
+				for (std::size_t got = 0; got < wanted; )
+				{
+					const std::size_t read = source.read(window.data() + last, wanted - got);
+					if (read == 0)
+					{
+						exhausted = true;
+						break;
+					}
+					got += read;
+					last += read;
+				}
+				starving = false;
+			}
+			if (first == last)
+			{
+				if (exhausted) break;
+				continue;
+			}
+
+			const char * start = window.data() + first;
+			const char * end = window.data() + last;
+			const size_t previous_line = line;
+			const size_t previous_column = column;
+			const parser::context previous = current;
+
+			auto result = tokenizer.parse(start, end, line, column, current);
+			const char * next = std::get<0>(result);
+			if (!exhausted && (next == end || next == start))
+			{
+				// token may continue in the next block
+				line = previous_line;
+				column = previous_column;
+				current = previous;
+				starving = true;
+				continue;
+			}
+
+			const bool admitted = tokenizer.account(std::get<1>(result), used);
+			callback(std::move(std::get<1>(result)));
+			if (!admitted || next == start) break;
+			first = next - window.data();
+		}
+	}
+
+	/// @class memory_source
+	/// @brief source reading from a document in memory
+	class memory_source
+	{
+		private:
+			const char * data;
+			std::size_t size;
+		public:
+			memory_source(const char * data, const std::size_t size) : data(data), size(size) {}
+
+			std::size_t read(char * buffer, const std::size_t wanted)
+			{
+				const std::size_t n = std::min(wanted, size);
+				std::memcpy(buffer, data, n);
+				data += n;
+				size -= n;
+				return n;
+			}
+	};
+
+	/// @class istream_source
+	/// @brief source reading from a std::istream in blocks
+	/// @details Together with parse_stream the tokenizer sees contiguous blocks and scans them in bulk, instead of
+	///			pulling every byte through a std::istreambuf_iterator.
+	class istream_source
+	{
+		private:
+			std::istream & in;
+		public:
+			istream_source(std::istream & in) : in(in) {}
+
+			std::size_t read(char * buffer, const std::size_t wanted)
+			{
+				in.read(buffer, static_cast<std::streamsize>(wanted));
+				return static_cast<std::size_t>(in.gcount());
+			}
+	};
+
+#if defined(__unix__) || defined(__APPLE__)
+	/// @class fd_source
+	/// @brief source reading from a POSIX file descriptor, e.g. a file, pipe or socket
+	/// @note The descriptor is not closed. A read error ends the document and marks the source as failed.
+	class fd_source
+	{
+		private:
+			int fd;
+			bool broken;
+		public:
+			fd_source(const int fd) : fd(fd), broken(false) {}
+
+			inline bool failed() const {return broken;}
+
+			std::size_t read(char * buffer, const std::size_t wanted)
+			{
+				std::size_t n = 0;
+				// a pipe or socket hands out what it has, so keep reading until the block is full
+				while (n < wanted && !broken)
+				{
+					const ssize_t got = ::read(fd, buffer + n, wanted - n);
+					if (got > 0) n += static_cast<std::size_t>(got);
+					else if (got == 0) break;
+					else if (errno != EINTR) broken = true;
+				}
+				return n;
+			}
+	};
+#endif
+
+	/// @class prefetching_source
+	/// @brief source reading the next block of another source on a thread of its own
+	/// @tparam Source class with a method std::size_t read(char * buffer, std::size_t size)
+	/// @details While the consumer works on one block the next one is already read, so a slow source like a
+	///			decompressing gzip_source or zstd_source overlaps with tokenizing. Two blocks are used in turn, hence
+	///			memory stays bounded by twice the block size. An exception thrown by the source is rethrown by read.
+	template <typename Source>
+	class prefetching_source
+	{
+		private:
+			Source & source;
+			std::vector<char> blocks[2];
+			std::size_t sizes[2];
+
+			/// block the consumer reads from, number of blocks ready and read position within the front block
+			std::size_t front;
+			std::size_t ready;
+			std::size_t offset;
+
+			bool stopping;
+			std::exception_ptr failure;
+			std::mutex mutex;
+			std::condition_variable changed;
+			std::thread reader;
+
+			void prefetch()
+			{
+				std::size_t back = 0;
+				while (true)
+				{
+					{
+						std::unique_lock<std::mutex> lock(mutex);
+						changed.wait(lock, [this]{return ready < 2 || stopping;});
+						if (stopping) return;
+					}
+
+					// the back block belongs to this thread until it is handed over
+					std::size_t n = 0;
+					std::exception_ptr error;
+					try {n = source.read(blocks[back].data(), blocks[back].size());}
+					catch (...) {error = std::current_exception();}
+
+					std::lock_guard<std::mutex> lock(mutex);
+					sizes[back] = n;
+					failure = error;
+					++ready;
+					changed.notify_all();
+					if (n == 0) return;
+					back ^= 1;
+				}
+			}
+
+		public:
+			/// @param source source to read from; it is read from another thread until the end of the document
+			/// @param block_size number of bytes read at once
+			prefetching_source(Source & source, const std::size_t block_size = 1 << 16) :
+				source(source), sizes{0, 0}, front(0), ready(0), offset(0), stopping(false)
+			{
+				blocks[0].resize(std::max<std::size_t>(block_size, 1));
+				blocks[1].resize(std::max<std::size_t>(block_size, 1));
+				reader = std::thread(&prefetching_source::prefetch, this);
+			}
+
+			prefetching_source(const prefetching_source &) = delete;
+			prefetching_source& operator = (const prefetching_source &) = delete;
+
+			~prefetching_source()
+			{
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					stopping = true;
+				}
+				changed.notify_all();
+				reader.join();
+			}
+
+			std::size_t read(char * buffer, const std::size_t wanted)
+			{
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					changed.wait(lock, [this]{return ready > 0;});
+					if (sizes[front] == 0)
+					{
+						if (failure) std::rethrow_exception(failure);
+						return 0;
+					}
+				}
+
+				// the front block belongs to this thread until it is handed back
+				const std::size_t n = std::min(wanted, sizes[front] - offset);
+				std::memcpy(buffer, blocks[front].data() + offset, n);
+				offset += n;
+				if (offset == sizes[front])
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					offset = 0;
+					front ^= 1;
+					--ready;
+					changed.notify_all();
+				}
+				return n;
+			}
+	};
+
+	/// @class transcoding_source
+	/// @brief source converting the document of another source to UTF-8
+	/// @tparam Source class with a method std::size_t read(char * buffer, std::size_t size)
+	/// @details The encoding is sniffed from the first block, which is read on the first call of read: a byte
+	///			order mark wins over a meta charset, which wins over the fallback. Afterwards the raw document is
+	///			converted block by block, so neither the raw nor the converted document is ever held completely.
+	template <typename Source>
+	class transcoding_source
+	{
+		private:
+			Source & source;
+			transcoder converter;
+			encoding fallback;
+			std::vector<char> raw;
+			std::string converted;
+			std::size_t offset;
+			bool sniffed;
+			bool exhausted;
+
+			/// @brief reads and converts the next block
+			/// @retval true some bytes have been converted
+			/// @retval false the document has ended
+			bool refill()
+			{
+				converted.clear();
+				offset = 0;
+				while (converted.empty() && !exhausted)
+				{
+					std::size_t n = source.read(raw.data(), raw.size());
+					std::size_t skip = 0;
+					if (!sniffed)
+					{
+						// the byte order mark and a meta charset within the prescanned 1024 bytes must have arrived
+						// before the encoding is decided
+						while (n != 0 && n < 1024)
+						{
+							const std::size_t more = source.read(raw.data() + n, raw.size() - n);
+							if (more == 0) break;
+							n += more;
+						}
+						const encoding_detection detection = detect_encoding(raw.data(), n, fallback);
+						converter = transcoder(detection.detected);
+						skip = detection.bom_size;
+						sniffed = true;
+					}
+					if (n == 0)
+					{
+						exhausted = true;
+						converter.finish(converted);
+					}
+					else converter.transcode(raw.data() + skip, n - skip, converted);
+				}
+				return !converted.empty();
+			}
+
+		public:
+			/// @param source source of the raw document
+			/// @param fallback encoding assumed if the document does not declare one
+			/// @param block_size number of raw bytes read at once; the first block should hold the meta charset
+			transcoding_source(Source & source, const encoding fallback = encoding::utf8, const std::size_t block_size = 1 << 16) :
+				source(source), fallback(fallback), raw(std::max<std::size_t>(block_size, 1024)), offset(0), sniffed(false), exhausted(false)
+			{}
+
+			/// @brief gives the encoding of the document
+			/// @return sniffed encoding; encoding::unknown before the first call of read
+			inline encoding get_encoding() const {return sniffed ? converter.get_encoding() : encoding::unknown;}
+
+			std::size_t read(char * buffer, const std::size_t wanted)
+			{
+				if (offset == converted.size() && !refill()) return 0;
+				const std::size_t n = std::min(wanted, converted.size() - offset);
+				std::memcpy(buffer, converted.data() + offset, n);
+				offset += n;
+				return n;
+			}
+	};
+
+}
+
+#endif
@@ -5,11 +5,14 @@
 #ifndef __TAGSOUP_TAGS_HPP__
 #define __TAGSOUP_TAGS_HPP__
 
+#include <cstdint>
+#include <cstddef>
 #include <string>
 #include <vector>
 #include <tuple>
 #include <utility>
 #include <tagsoup/token.hpp>
+#include <tagsoup/attributes.hpp>
 
 namespace ts
 {
@@ -20,14 +23,17 @@ namespace ts
 	{
 		private:
 			std::string id;
-			std::vector<std::pair<std::string, std::string>> attributes;
+			attribute_list attributes;
 		public:
-			using const_attribute_iterator = decltype(attributes.cbegin());
+			using const_attribute_iterator = attribute_list::const_iterator;
 
-			open_tag(const std::string id, const std::vector<std::pair<std::string, std::string>> attributes) : id(id), attributes(attributes) {}
+			open_tag(std::string id, attribute_list attributes) : id(std::move(id)), attributes(std::move(attributes))
+			{this->attributes.build_index();}
 			const std::string& get_id() const {return id;}
 			const_attribute_iterator cbegin_attributes() const {return attributes.cbegin();}
 			const_attribute_iterator cend_attributes() const {return attributes.cend();}
+			const_attribute_iterator find_attribute(const std::string & name) const {return attributes.find(name);}
+			std::size_t count_attributes() const {return attributes.size();}
 	};
 
 	class closing_tag
@@ -35,7 +41,7 @@ namespace ts
 		private:
 			std::string id;
 		public:
-			closing_tag(const std::string id) : id(id) {}
+			closing_tag(std::string id) : id(std::move(id)) {}
 			const std::string& get_id() const {return id;}
 	};
 
@@ -43,14 +49,17 @@ namespace ts
 	{
 		private:
 			std::string id;
-			std::vector<std::pair<std::string, std::string>> attributes;
+			attribute_list attributes;
 		public:
-			using const_attribute_iterator = decltype(attributes.cbegin());
+			using const_attribute_iterator = attribute_list::const_iterator;
 
-			empty_tag(const std::string id, const std::vector<std::pair<std::string, std::string>> attributes) : id(id), attributes(attributes) {}
+			empty_tag(std::string id, attribute_list attributes) : id(std::move(id)), attributes(std::move(attributes))
+			{this->attributes.build_index();}
 			const std::string& get_id() const {return id;}
 			const_attribute_iterator cbegin_attributes() const {return attributes.cbegin();}
 			const_attribute_iterator cend_attributes() const {return attributes.cend();}
+			const_attribute_iterator find_attribute(const std::string & name) const {return attributes.find(name);}
+			std::size_t count_attributes() const {return attributes.size();}
 	};
 
 	class comment
@@ -58,7 +67,7 @@ namespace ts
 		private:
 			std::string content;
 		public:
-			comment(const std::string content) : content(content) {}
+			comment(std::string content) : content(std::move(content)) {}
 			const std::string& get_content() const {return content;}
 	};
 
@@ -67,7 +76,7 @@ namespace ts
 		private:
 			std::string content;
 		public:
-			text(const std::string content) : content(content) {}
+			text(std::string content) : content(std::move(content)) {}
 			const std::string& get_content() const {return content;}
 	};
 
@@ -77,7 +86,7 @@ namespace ts
 			std::string id;
 			std::string code;
 		public:
-			pi(const std::string id, const std::string code) : id(id), code(code) {}
+			pi(std::string id, std::string code) : id(std::move(id)), code(std::move(code)) {}
 			const std::string& get_id() const {return id;}
 			const std::string& get_code() const {return code;}
 	};
@@ -87,7 +96,7 @@ namespace ts
 		private:
 			std::string code;
 		public:
-			cdata(const std::string code) : code(code) {}
+			cdata(std::string code) : code(std::move(code)) {}
 			const std::string& get_code() const {return code;}
 	};
 
@@ -96,7 +105,7 @@ namespace ts
 		private:
 			std::string id;
 		public:
-			dtd(const std::string id) : id(id) {}
+			dtd(std::string id) : id(std::move(id)) {}
 			const std::string& get_id() const {return id;}
 	};
 
@@ -105,7 +114,7 @@ namespace ts
 		private:
 			std::string description;
 		public:
-			unknown_tag(const std::string description) : description(description) {}
+			unknown_tag(std::string description) : description(std::move(description)) {}
 			const std::string& get_description() const {return description;}
 	};
 
@@ -113,13 +122,72 @@ namespace ts
 	using tag_token = token<open_tag, closing_tag, empty_tag, comment, text, pi, cdata, dtd, unknown_tag>;
 	using tag_token_signature = tag_token::signature;
 
-	tag_token make_open_tag_token(std::string id, std::vector<std::pair<std::string, std::string>> attributes)
+	/// @brief kinds of tag tokens in the order of the tag_token type list
+	enum class tag_kind : std::uint8_t
+	{
+		open_tag = 0,
+		closing_tag,
+		empty_tag,
+		comment,
+		text,
+		pi,
+		cdata,
+		dtd,
+		unknown_tag
+	};
+
+	/// @struct tag_flag
+	/// @brief bits the tokenizer sets in tag_token::flags
+	struct tag_flag
+	{
+		enum : std::uint8_t
+		{
+			/// some payload of the token is not well formed UTF-8 (or has been repaired, see utf8_validation)
+			invalid_utf8 = 1 << 0,
+			/// the token has been cut at a resource limit and the entity continues with the next token
+			truncated = 1 << 1,
+			/// the payload is a chunk of a larger entity which the next token continues
+			partial = 1 << 2,
+			/// the token is text made of markup the tokenizer could not make sense of, see parser::recover_soup
+			recovered = 1 << 3
+		};
+	};
+
+	/// number of different tag kinds
+	const std::size_t tag_kind_count = 9;
+
+	/// @brief gives the kind of the currently active value of \a token
+	/// @param token token to classify
+	/// @return kind of the token
+	inline tag_kind get_kind(const tag_token & token)
+	{
+		if (token.is_type<open_tag>()) return tag_kind::open_tag;
+		else if (token.is_type<closing_tag>()) return tag_kind::closing_tag;
+		else if (token.is_type<empty_tag>()) return tag_kind::empty_tag;
+		else if (token.is_type<comment>()) return tag_kind::comment;
+		else if (token.is_type<text>()) return tag_kind::text;
+		else if (token.is_type<pi>()) return tag_kind::pi;
+		else if (token.is_type<cdata>()) return tag_kind::cdata;
+		else if (token.is_type<dtd>()) return tag_kind::dtd;
+		else return tag_kind::unknown_tag;
+	}
+
+	/// @brief gives a human readable name of \a kind
+	/// @param kind kind to name
+	/// @return name which equals the name of the tag class
+	inline const char * get_kind_name(const tag_kind kind)
+	{
+		static const char * const names[tag_kind_count] = {"open_tag", "closing_tag", "empty_tag", "comment", "text", "pi", "cdata", "dtd", "unknown_tag"};
+		return names[static_cast<std::size_t>(kind)];
+	}
+
+	tag_token make_open_tag_token(std::string id, attribute_list attributes)
 	{return make_token(open_tag(std::move(id), std::move(attributes)), tag_token_signature());}
 
 	tag_token make_closing_tag_token(std::string id)
 	{return make_token(closing_tag(std::move(id)), tag_token_signature());}
 
-	tag_token make_empty_tag_token(std::string id, std::vector<std::pair<std::string, std::string>> attributes)
+	tag_token make_empty_tag_token(std::string id, attribute_list attributes)
 	{return make_token(empty_tag(std::move(id), std::move(attributes)), tag_token_signature());}
 
 	tag_token make_comment_token(std::string content)
@@ -7,6 +7,18 @@
 
 #include <tagsoup/parser.hpp>
 #include <tagsoup/tags.hpp>
+#include <tagsoup/batch.hpp>
+#include <tagsoup/token_table.hpp>
+#include <tagsoup/stream.hpp>
+#include <tagsoup/incremental.hpp>
+#include <tagsoup/dispatcher.hpp>
+#include <tagsoup/pipe.hpp>
+#include <tagsoup/splitter.hpp>
+#include <tagsoup/prefilter.hpp>
+#include <tagsoup/index.hpp>
+#include <tagsoup/fingerprint.hpp>
+#include <tagsoup/diff.hpp>
+#include <tagsoup/static_tokens.hpp>
 
 #endif
 
@@ -0,0 +1,125 @@
+/// @file adversarial.cpp
+/// @author Michael Koch
+/// @copyright CC BY 3.0
+/// @brief benchmarks hostile documents and checks that their cost grows linearly with their size
+/// @details Every document is built from a repeated unit at two sizes. Tokenizing four times the bytes must not take
+///			much more than four times as long, which a quadratic rescan would miss by far. Contiguous and single
+///			pass input must give the same tokens, with and without soup recovery where single pass input can tell.
+
+#include <tagsoup/tagsoup.hpp>
+#include <chrono>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+	struct adversary
+	{
+		const char * name;
+		std::string prefix;
+		std::string unit;
+		std::string suffix;
+	};
+
+	std::string build(const adversary & a, const std::size_t size)
+	{
+		std::string document = a.prefix;
+		while (document.size() < size) document += a.unit;
+		return document + a.suffix;
+	}
+
+	template <typename InputIterator>
+	std::string tokenize(const ts::parser & p, InputIterator first, const InputIterator last, std::size_t & count)
+	{
+		std::size_t line = 1;
+		std::size_t column = 0;
+		std::string kinds;
+		count = 0;
+		p.parse_all(first, last, line, column, [&kinds, &count](ts::tag_token && token)
+		{
+			kinds += static_cast<char>('a' + static_cast<int>(ts::get_kind(token)));
+			++count;
+		});
+		return kinds;
+	}
+
+	/// @return fastest of some runs in milliseconds
+	double measure(const ts::parser & p, const std::string & document, std::size_t & count)
+	{
+		double fastest = 0;
+		for (int run = 0; run < 3; ++run)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			tokenize(p, document.cbegin(), document.cend(), count);
+			const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			if (run == 0 || ms < fastest) fastest = ms;
+		}
+		return fastest;
+	}
+
+	std::string tokenize_stream(const ts::parser & p, const std::string & document, std::size_t & count)
+	{
+		std::istringstream in(document);
+		return tokenize(p, std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>(), count);
+	}
+
+}
+
+int main()
+{
+	const std::size_t size = 1 << 18;
+	const std::vector<adversary> adversaries =
+	{
+		{"deep nesting", "", "<div>", "</div>"},
+		{"deep nesting with attributes", "", "<div class=a id=b>", ""},
+		{"unclosed tags", "", "<p <a ", ""},
+		{"unclosed quote", "<a href='", "x", ""},
+		{"stray '<'", "", "a < b <", ""},
+		{"lone '<'", "", "<", ""},
+		{"broken closing tags", "", "</ >", ""},
+		{"huge attribute value", "<a href=\"", "0123456789", "\">"},
+		{"many attributes", "<a", " x=1", ">"},
+		{"unclosed comment", "<!--", "-", ""}
+	};
+
+	bool passed = true;
+	for (const bool recovering : {false, true})
+	{
+		ts::parser p;
+		p.recover_soup(recovering);
+		for (const adversary & a : adversaries)
+		{
+			const std::string small = build(a, size);
+			const std::string large = build(a, 4 * size);
+			std::size_t small_count = 0;
+			std::size_t large_count = 0;
+			const double small_ms = measure(p, small, small_count);
+			const double large_ms = measure(p, large, large_count);
+			std::cout << (recovering ? "soup " : "") << a.name << ": " << large.size() << " bytes, " << large_count << " tokens, "
+				<< large_ms << " ms, " << large.size() / 1048.576 / (large_ms > 0 ? large_ms : 1) << " MB/s" << std::endl;
+
+			// generous for noise, but far below the factor 16 of quadratic work
+			if (large_ms > 8 * small_ms + 5)
+			{
+				std::cerr << "FAILED: " << a.name << " takes " << small_ms << " ms for " << small.size() << " bytes but "
+					<< large_ms << " ms for " << large.size() << " bytes" << std::endl;
+				passed = false;
+			}
+
+			// single pass input cannot look ahead, so recovered text splits differently
+			if (recovering) continue;
+			std::size_t count = 0;
+			std::size_t stream_count = 0;
+			if (tokenize(p, small.cbegin(), small.cend(), count) != tokenize_stream(p, small, stream_count))
+			{
+				std::cerr << "FAILED: " << a.name << " gives other tokens for single pass input" << std::endl;
+				passed = false;
+			}
+		}
+	}
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,91 @@
+/// @file allocations.cpp
+/// @author Michael Koch
+/// @copyright CC BY 3.0
+/// @brief counts heap allocations per token: payloads are moved from the parser into the tokens, never copied
+
+#include <tagsoup/tagsoup.hpp>
+#include <cstdlib>
+#include <new>
+#include <iostream>
+#include <string>
+#include <utility>
+
+namespace
+{
+	std::size_t allocations = 0;
+}
+
+void * operator new(std::size_t size)
+{
+	++allocations;
+	if (void * p = std::malloc(size != 0 ? size : 1)) return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void * p) noexcept {std::free(p);}
+void operator delete(void * p, std::size_t) noexcept {std::free(p);}
+
+namespace
+{
+
+	bool passed = true;
+
+	void expect(const char * what, const std::size_t counted, const std::size_t expected)
+	{
+		if (counted == expected) return;
+		std::cerr << what << ": " << counted << " allocations instead of " << expected << std::endl;
+		passed = false;
+	}
+
+	/// a payload too long for the small string optimization, so that a copy would allocate
+	std::string payload(const char c) {return std::string(64, c);}
+
+	/// @brief counts the allocations of tokenizing a document
+	std::size_t count_allocations(const std::string & document, std::size_t & tokens)
+	{
+		ts::parser p;
+		std::size_t line = 1;
+		std::size_t column = 0;
+		tokens = 0;
+		const std::size_t before = allocations;
+		p.parse_all(document.cbegin(), document.cend(), line, column, [&tokens](ts::tag_token &&) {++tokens;});
+		return allocations - before;
+	}
+
+}
+
+int main()
+{
+	// building a token moves its strings, whose buffers were allocated before
+	std::string content = payload('t');
+	std::string id = payload('i');
+	std::string target = payload('p');
+	std::string code = payload('c');
+	ts::attribute_list attributes;
+	attributes.emplace_back(payload('n'), payload('v'));
+
+	std::size_t before = allocations;
+	ts::tag_token text = ts::make_text_token(std::move(content));
+	ts::tag_token tag = ts::make_open_tag_token(std::move(id), std::move(attributes));
+	ts::tag_token instruction = ts::make_pi_token(std::move(target), std::move(code));
+	expect("building tokens", allocations - before, 0);
+
+	// moving tokens, e.g. into a growing std::vector<tag_token>, moves their payloads
+	before = allocations;
+	ts::tag_token moved_text(std::move(text));
+	ts::tag_token moved_tag(std::move(tag));
+	moved_text = std::move(moved_tag);
+	moved_tag = std::move(instruction);
+	expect("moving tokens", allocations - before, 0);
+
+	// short names and values fit into the strings and tags with up to attribute_list::small_capacity attributes
+	// reuse the block of the previous tag, hence tokenizing them allocates one block per thread and then nothing
+	std::string document;
+	for (int i = 0; i < 1000; ++i) document += "<p id=x class='y'>some text</p><br/><!-- note -->";
+	std::size_t tokens = 0;
+	expect("tokenizing small tokens", count_allocations(document, tokens), 1);
+	expect("tokenizing small tokens again", count_allocations(document, tokens), 0);
+
+	std::cout << "checked " << tokens << " tokens" << std::endl;
+	return passed ? 0 : 1;
+}
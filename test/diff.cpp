@@ -0,0 +1,190 @@
+/// @file diff.cpp
+/// @author Michael Koch
+/// @copyright CC BY 3.0
+/// @brief checks that token diffs are valid edit scripts, minimal for small changes and linear in the page size
+/// @details Small random sequences are compared against the length of their longest common subsequence. Generated
+///			pages are changed in a growing share of their texts at two sizes; four times the tokens must not take
+///			much more than four times as long, which an unbounded O((N+M)D) search would miss by far.
+
+#include <tagsoup/tagsoup.hpp>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+	bool passed = true;
+
+	void fail(const std::string & what)
+	{
+		std::cerr << "FAILED: " << what << std::endl;
+		passed = false;
+	}
+
+	/// @brief checks that \a changes turn \a old_tokens into \a new_tokens
+	/// @return number of removed plus inserted tokens, a modified one counting as both
+	std::size_t check_script(const ts::hashed_tokens & old_tokens, const ts::hashed_tokens & new_tokens,
+		const std::vector<ts::token_change> & changes, const std::string & name)
+	{
+		std::vector<bool> old_changed(old_tokens.size(), false);
+		std::vector<bool> new_changed(new_tokens.size(), false);
+		std::vector<std::pair<std::size_t, std::size_t>> pairs;
+		std::size_t cost = 0;
+		for (const ts::token_change & change : changes)
+		{
+			if (change.type != ts::change_type::inserted) old_changed[change.old_position] = true;
+			if (change.type != ts::change_type::removed) new_changed[change.new_position] = true;
+			if (change.type == ts::change_type::modified)
+			{
+				if (old_tokens.shapes[change.old_position] != new_tokens.shapes[change.new_position]) fail(name + ": modified tokens differ in shape");
+				pairs.emplace_back(change.old_position, change.new_position);
+				cost += 2;
+			}
+			else ++cost;
+		}
+
+		// the unchanged tokens must be equal in order, and together with the modified ones keep the order
+		std::size_t j = 0;
+		for (std::size_t i = 0; i < old_tokens.size(); ++i)
+		{
+			if (old_changed[i]) continue;
+			while (j < new_tokens.size() && new_changed[j]) ++j;
+			if (j == new_tokens.size() || old_tokens.hashes[i] != new_tokens.hashes[j])
+			{
+				fail(name + ": unchanged tokens differ");
+				return cost;
+			}
+			pairs.emplace_back(i, j++);
+		}
+		while (j < new_tokens.size() && new_changed[j]) ++j;
+		if (j != new_tokens.size()) fail(name + ": unchanged tokens differ in number");
+		std::sort(pairs.begin(), pairs.end());
+		for (std::size_t k = 1; k < pairs.size(); ++k)
+			if (pairs[k].second <= pairs[k - 1].second) fail(name + ": changes out of order");
+		return cost;
+	}
+
+	std::size_t get_distance(const std::vector<std::uint64_t> & a, const std::vector<std::uint64_t> & b)
+	{
+		std::vector<std::vector<std::size_t>> common(a.size() + 1, std::vector<std::size_t>(b.size() + 1, 0));
+		for (std::size_t i = 1; i <= a.size(); ++i)
+			for (std::size_t j = 1; j <= b.size(); ++j)
+				common[i][j] = a[i - 1] == b[j - 1] ? common[i - 1][j - 1] + 1 : std::max(common[i - 1][j], common[i][j - 1]);
+		return a.size() + b.size() - 2 * common[a.size()][b.size()];
+	}
+
+	/// @brief builds a page of \a items list entries, changing the text of every \a every-th one
+	/// @param unique whether each entry holds a link of its own, which anchors the comparison
+	std::vector<ts::tag_token> build(const std::size_t items, const std::size_t every, const bool unique, const bool changed)
+	{
+		std::string document = "<html><body><ul>";
+		for (std::size_t i = 0; i < items; ++i)
+		{
+			document += "<li>";
+			if (unique) document += "<a href=\"/item/" + std::to_string(i) + "\">";
+			document += "entry " + std::to_string(i) + (changed && i % every == 0 ? " changed" : "");
+			if (unique) document += "</a>";
+			document += "</li>";
+		}
+		document += "</ul></body></html>";
+
+		ts::parser p;
+		std::vector<ts::tag_token> tokens;
+		std::size_t line = 1;
+		std::size_t column = 0;
+		p.parse_all(document.cbegin(), document.cend(), line, column, [&tokens](ts::tag_token && token) {tokens.push_back(std::move(token));});
+		return tokens;
+	}
+
+	/// @return fastest of some runs in milliseconds
+	double measure(const ts::hashed_tokens & old_tokens, const ts::hashed_tokens & new_tokens, std::vector<ts::token_change> & changes)
+	{
+		double fastest = 0;
+		for (int run = 0; run < 3; ++run)
+		{
+			ts::token_differ differ;
+			const auto start = std::chrono::steady_clock::now();
+			changes = differ.diff(old_tokens, new_tokens);
+			const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			if (run == 0 || ms < fastest) fastest = ms;
+		}
+		return fastest;
+	}
+
+}
+
+int main()
+{
+	std::mt19937 random(5);
+	ts::token_differ differ;
+	for (int round = 0; round < 2000; ++round)
+	{
+		ts::hashed_tokens old_tokens;
+		ts::hashed_tokens new_tokens;
+		for (std::size_t i = random() % 40; i != 0; --i) old_tokens.hashes.push_back(random() % 6);
+		new_tokens.hashes = old_tokens.hashes;
+		for (std::size_t edits = random() % 8; edits != 0; --edits)
+		{
+			std::vector<std::uint64_t> & h = new_tokens.hashes;
+			const std::size_t at = h.empty() ? 0 : random() % h.size();
+			if (random() % 2 == 0 || h.empty()) h.insert(h.begin() + at, random() % 6);
+			else h.erase(h.begin() + at);
+		}
+		// two kinds of shapes, so that some removed and inserted tokens get paired
+		for (const std::uint64_t h : old_tokens.hashes) old_tokens.shapes.push_back(h % 2);
+		for (const std::uint64_t h : new_tokens.hashes) new_tokens.shapes.push_back(h % 2);
+
+		const std::string name = "random round " + std::to_string(round);
+		const std::size_t cost = check_script(old_tokens, new_tokens, differ.diff(old_tokens, new_tokens), name);
+		if (cost != get_distance(old_tokens.hashes, new_tokens.hashes)) fail(name + ": edit script is not minimal");
+	}
+
+	struct page
+	{
+		const char * name;
+		std::size_t every;
+		bool unique;
+	};
+	const std::vector<page> pages =
+	{
+		{"every 1000th text changed", 1000, true},
+		{"every 10th text changed", 10, true},
+		{"every text changed", 1, true},
+		{"every text changed without anchors", 1, false}
+	};
+
+	const std::size_t items = 5000;
+	for (const page & p : pages)
+	{
+		double ms[2];
+		std::size_t tokens = 0;
+		std::size_t changed = 0;
+		for (int size = 0; size < 2; ++size)
+		{
+			const std::size_t n = size == 0 ? items : 4 * items;
+			const ts::hashed_tokens old_tokens = ts::hash_tokens(build(n, p.every, p.unique, false));
+			const ts::hashed_tokens new_tokens = ts::hash_tokens(build(n, p.every, p.unique, true));
+			std::vector<ts::token_change> changes;
+			ms[size] = measure(old_tokens, new_tokens, changes);
+			check_script(old_tokens, new_tokens, changes, p.name);
+
+			// every changed text is found as modified, nothing else
+			const std::size_t texts = (n + p.every - 1) / p.every;
+			if (changes.size() != texts || std::any_of(changes.begin(), changes.end(),
+				[](const ts::token_change & c) {return c.type != ts::change_type::modified;}))
+				fail(std::string(p.name) + ": " + std::to_string(changes.size()) + " changes instead of " + std::to_string(texts) + " modified texts");
+			tokens = old_tokens.size();
+			changed = changes.size();
+		}
+		std::cout << p.name << ": " << tokens << " tokens, " << changed << " changes, " << ms[1] << " ms" << std::endl;
+
+		// generous for noise, but far below the factor 16 of quadratic work
+		if (ms[1] > 8 * ms[0] + 5) fail(std::string(p.name) + " takes " + std::to_string(ms[0]) + " ms for " + std::to_string(items)
+			+ " items but " + std::to_string(ms[1]) + " ms for four times as many");
+	}
+	return passed ? 0 : 1;
+}
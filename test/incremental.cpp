@@ -0,0 +1,118 @@
+/// @file incremental.cpp
+/// @author Michael Koch
+/// @copyright CC BY 3.0
+/// @brief checks that edited documents keep the tokens of a fresh tokenization and that edits cost no more on longer documents
+/// @details Random edits, some of them erasing or inserting many tokens at once, are compared token by token with
+///			tokenizing the edited document from scratch. Then keystrokes in the middle of a page are timed at two
+///			sizes of the page; four times the tokens must not make them much slower, which shifting all tokens
+///			behind each keystroke would by far.
+
+#include <tagsoup/tagsoup.hpp>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+	bool passed = true;
+
+	std::string describe(const ts::tag_token & token)
+	{
+		std::string s = ts::get_kind_name(ts::get_kind(token));
+		if (token.is_type<ts::text>()) s += "[" + token.get<ts::text>().get_content() + "]";
+		else if (token.is_type<ts::open_tag>()) s += "[" + token.get<ts::open_tag>().get_id() + "]";
+		else if (token.is_type<ts::closing_tag>()) s += "[" + token.get<ts::closing_tag>().get_id() + "]";
+		else if (token.is_type<ts::comment>()) s += "[" + token.get<ts::comment>().get_content() + "]";
+		else if (token.is_type<ts::unknown_tag>()) s += "[" + token.get<ts::unknown_tag>().get_description() + "]";
+		return s + std::to_string(token.flags);
+	}
+
+	bool equal(const ts::incremental_document & edited, const ts::incremental_document & fresh)
+	{
+		if (edited.size() != fresh.size() || edited.get_source() != fresh.get_source()) return false;
+		for (std::size_t i = 0; i < edited.size(); ++i)
+		{
+			if (describe(edited.get_token(i)) != describe(fresh.get_token(i)) || edited.get_offset(i) != fresh.get_offset(i) ||
+				edited.get_line(i) != fresh.get_line(i) || edited.get_column(i) != fresh.get_column(i) ||
+				edited.get_context(i) != fresh.get_context(i)) return false;
+		}
+		return true;
+	}
+
+	std::string build(const std::size_t items)
+	{
+		std::string document = "<html><body>\n";
+		for (std::size_t i = 0; i < items; ++i)
+			document += "<div class=item><a href=\"/item/" + std::to_string(i) + "\">entry</a> some text</div>\n";
+		return document + "</body></html>\n";
+	}
+
+	/// @return fastest of some runs of typing markup with a line break into the middle, in milliseconds per keystroke
+	double measure(const ts::parser & p, const std::string & document)
+	{
+		const std::string word = "<i>typed</i>\n";
+		double fastest = 0;
+		for (int run = 0; run < 3; ++run)
+		{
+			ts::incremental_document edited(p, document);
+			std::size_t offset = document.size() / 2;
+
+			// the first edit at a place moves the gap there
+			edited.edit(offset, 0, " ");
+			const auto start = std::chrono::steady_clock::now();
+			for (int repeat = 0; repeat < 300; ++repeat)
+				for (const char c : word) edited.edit(offset++, 0, std::string(1, c));
+			const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / (300 * word.size());
+			if (run == 0 || ms < fastest) fastest = ms;
+		}
+		return fastest;
+	}
+
+}
+
+int main()
+{
+	ts::parser p;
+	p.raw_text_elements(ts::raw_text::all);
+	std::mt19937 random(7);
+	const std::vector<std::string> pieces = {"<a>", "</a>", "<script>", "</script>", "x", "<!--", "-->", "<", ">", " ", "\n", "\"", "<b c='1'>", "</scr", "ipt>", "text "};
+	for (int round = 0; round < 20; ++round)
+	{
+		std::string document;
+		for (int i = 0; i < 1500; ++i) document += pieces[random() % pieces.size()];
+		ts::incremental_document edited(p, document);
+		for (int e = 0; e < 40; ++e)
+		{
+			const std::size_t offset = random() % (document.size() + 1);
+			const std::size_t erased = std::min<std::size_t>(random() % 4 == 0 ? random() % 2000 : random() % 4, document.size() - offset);
+			std::string inserted;
+			for (std::size_t n = random() % 4 == 0 ? random() % 400 : random() % 2; n != 0; --n) inserted += pieces[random() % pieces.size()];
+			edited.edit(offset, erased, inserted);
+			document.replace(offset, erased, inserted);
+			if (!equal(edited, ts::incremental_document(p, document)))
+			{
+				std::cerr << "FAILED: tokens differ after edit " << e << " of round " << round << std::endl;
+				passed = false;
+				break;
+			}
+		}
+	}
+
+	const std::size_t items = 20000;
+	const std::string small = build(items);
+	const std::string large = build(4 * items);
+	const double small_ms = measure(p, small);
+	const double large_ms = measure(p, large);
+	std::cout << "keystroke: " << small_ms * 1000 << " us for " << small.size() << " bytes, " << large_ms * 1000 << " us for " << large.size() << " bytes" << std::endl;
+
+	// generous for noise, but below the factor 4 of work on all tokens behind the edit
+	if (large_ms > 3 * small_ms + 0.005)
+	{
+		std::cerr << "FAILED: a keystroke takes " << small_ms << " ms for " << small.size() << " bytes but " << large_ms << " ms for " << large.size() << " bytes" << std::endl;
+		passed = false;
+	}
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,21 @@
+#!/bin/sh
+# builds and runs every check in this directory, once as given and once with the statistics of the parser
+# usage: test/run.sh [compiler flags], e.g. test/run.sh -std=c++17 -O2
+set -e
+here=$(cd "$(dirname "$0")" && pwd)
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+mkdir "$work/include"
+ln -s "$here/.." "$work/include/tagsoup"
+flags=${*:--std=c++14 -O2}
+status=0
+for variant in "" -DTAGSOUP_STATISTICS
+do
+	for source in "$here"/*.cpp
+	do
+		name=$(basename "$source" .cpp)
+		${CXX:-c++} $flags $variant -Wall -I"$work/include" "$source" -o "$work/$name" -lz -pthread
+		if "$work/$name"; then echo "passed: $name $variant"; else echo "FAILED: $name $variant"; status=1; fi
+	done
+done
+exit $status
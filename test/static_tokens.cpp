@@ -0,0 +1,106 @@
+/// @file static_tokens.cpp
+/// @author Michael Koch
+/// @copyright CC BY 3.0
+/// @brief checks that the constexpr scanner gives the tokens of the tokenizer for well formed fragments
+
+#include <tagsoup/tagsoup.hpp>
+#include <tagsoup/static_tokens.hpp>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#if __cplusplus >= 201402L
+
+namespace
+{
+
+	template <typename Tag>
+	std::string describe_tag(const Tag & tag)
+	{
+		std::string s = " " + tag.get_id();
+		for (auto i = tag.cbegin_attributes(); i != tag.cend_attributes(); ++i) s += " " + i->first + "=" + i->second;
+		return s;
+	}
+
+	std::string describe(const ts::tag_token & token)
+	{
+		std::string s = ts::get_kind_name(ts::get_kind(token));
+		if (token.is_type<ts::open_tag>()) s += describe_tag(token.get<ts::open_tag>());
+		else if (token.is_type<ts::empty_tag>()) s += describe_tag(token.get<ts::empty_tag>());
+		else if (token.is_type<ts::closing_tag>()) s += " " + token.get<ts::closing_tag>().get_id();
+		else if (token.is_type<ts::text>()) s += " " + token.get<ts::text>().get_content();
+		else if (token.is_type<ts::comment>()) s += " " + token.get<ts::comment>().get_content();
+		else if (token.is_type<ts::cdata>()) s += " " + token.get<ts::cdata>().get_code();
+		return s + "\n";
+	}
+
+	template <std::size_t N, std::size_t A>
+	std::string describe(const ts::static_token_table<N, A> & table)
+	{
+		std::string s;
+		for (std::size_t i = 0; i < table.get_size(); ++i)
+		{
+			const ts::static_token & token = table[i];
+			s += ts::get_kind_name(token.kind);
+			if (token.kind == ts::tag_kind::open_tag || token.kind == ts::tag_kind::empty_tag)
+			{
+				s += " " + table.get_view(token.value).to_string();
+				for (std::size_t j = 0; j < token.attribute_count; ++j)
+				{
+					const ts::static_attribute & attribute = table.get_attribute(i, j);
+					s += " " + table.get_view(attribute.name).to_string() + "=" + table.get_view(attribute.value).to_string();
+				}
+			}
+			else if (token.kind != ts::tag_kind::pi && token.kind != ts::tag_kind::dtd && token.kind != ts::tag_kind::unknown_tag)
+				s += " " + table.get_view(token.value).to_string();
+			s += "\n";
+		}
+		return s;
+	}
+
+	std::string tokenize(const std::string & source)
+	{
+		ts::parser p;
+		std::size_t line = 1;
+		std::size_t column = 0;
+		std::string s;
+		p.parse_all(source.cbegin(), source.cend(), line, column, [&s](ts::tag_token && token) {s += describe(token);});
+		return s;
+	}
+
+}
+
+#define CHECK_FRAGMENT(source) check(#source, describe(ts::tokenize_static<32>(source)), tokenize(source))
+
+int main()
+{
+	bool passed = true;
+	auto check = [&passed](const char * name, const std::string & scanned, const std::string & tokenized)
+	{
+		if (scanned == tokenized) return;
+		std::cerr << name << " is scanned as\n" << scanned << "but tokenized as\n" << tokenized;
+		passed = false;
+	};
+
+	CHECK_FRAGMENT("<p class='x'>hi</p>");
+	CHECK_FRAGMENT("<a href=x/>");
+	CHECK_FRAGMENT("<a b=/>");
+	CHECK_FRAGMENT("<a href=x>y</a>");
+	CHECK_FRAGMENT("<a href = \"x y\" title='z'>");
+	CHECK_FRAGMENT("<input disabled>");
+	CHECK_FRAGMENT("<input disabled/>");
+	CHECK_FRAGMENT("<input disabled value=1 />");
+	CHECK_FRAGMENT("<br/><br />");
+	CHECK_FRAGMENT("<!-- a comment --><![CDATA[ <x> ]]>");
+	CHECK_FRAGMENT("<!DOCTYPE html><?xml version='1.0'?>");
+	CHECK_FRAGMENT("<ul>\n\t<li>one</li>\n\t<li>two</li>\n</ul>");
+	CHECK_FRAGMENT("</p >text");
+	return passed ? 0 : 1;
+}
+
+#else
+
+// the constexpr scanner needs C++14
+int main() {return 0;}
+
+#endif
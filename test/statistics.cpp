@@ -0,0 +1,65 @@
+/// @file statistics.cpp
+/// @author Michael Koch
+/// @copyright CC BY 3.0
+/// @brief checks the counters of parser::statistics; test/run.sh builds every check with TAGSOUP_STATISTICS once
+
+#include <tagsoup/tagsoup.hpp>
+#include <iostream>
+#include <string>
+
+#ifdef TAGSOUP_STATISTICS
+
+int main()
+{
+	bool passed = true;
+	auto expect = [&passed](const char * what, const std::uint64_t counted, const std::uint64_t expected)
+	{
+		if (counted == expected) return;
+		std::cerr << what << ": " << counted << " instead of " << expected << std::endl;
+		passed = false;
+	};
+
+	const std::string document = "<p a=b c=d e>text</p><!--c--><br/><x <y>tail<!-- open";
+	ts::parser p;
+	ts::parser::statistics counters;
+	p.collect_statistics(&counters);
+	std::size_t line = 1;
+	std::size_t column = 0;
+	std::uint64_t tokens = 0;
+	p.parse_all(document.cbegin(), document.cend(), line, column, [&tokens](ts::tag_token &&) {++tokens;});
+
+	using ts::tag_kind;
+	expect("open tags", counters.tokens[static_cast<std::size_t>(tag_kind::open_tag)], 1);
+	expect("closing tags", counters.tokens[static_cast<std::size_t>(tag_kind::closing_tag)], 1);
+	expect("empty tags", counters.tokens[static_cast<std::size_t>(tag_kind::empty_tag)], 1);
+	expect("comments", counters.tokens[static_cast<std::size_t>(tag_kind::comment)], 1);
+	expect("texts", counters.tokens[static_cast<std::size_t>(tag_kind::text)], 2);
+	expect("unknown tags", counters.tokens[static_cast<std::size_t>(tag_kind::unknown_tag)], 1);
+	expect("incomplete entities", counters.incomplete, 1);
+
+	// the incomplete entity is counted once, under incomplete only
+	std::uint64_t counted = counters.incomplete;
+	for (const std::uint64_t n : counters.tokens) counted += n;
+	expect("all tokens", counted, tokens);
+
+	std::uint64_t errors = 0;
+	for (const std::uint64_t n : counters.errors) errors += n;
+	expect("errors", errors, 1);
+
+	// the br without attributes and the p with three; "y>" after the broken tag is text
+	expect("tags with no attributes", counters.attributes[0], 1);
+	expect("tags with three attributes", counters.attributes[3], 1);
+	expect("longest entity", counters.longest_entity, std::string("<p a=b c=d e>").size());
+
+	ts::parser::statistics sum;
+	sum += counters;
+	sum += counters;
+	expect("merged incomplete entities", sum.incomplete, 2);
+	return passed ? 0 : 1;
+}
+
+#else
+
+int main() {return 0;}
+
+#endif
@@ -0,0 +1,90 @@
+/// @file token_table.cpp
+/// @author Michael Koch
+/// @copyright CC BY 3.0
+/// @brief checks that the spans of a token_table hold the ids and attributes the tokenizer gives
+
+#include <tagsoup/tagsoup.hpp>
+#include <tagsoup/token_table.hpp>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+	template <typename Tag>
+	std::string describe_tag(const Tag & tag)
+	{
+		std::string s = " " + tag.get_id();
+		for (auto i = tag.cbegin_attributes(); i != tag.cend_attributes(); ++i) s += " " + i->first + "=" + i->second;
+		return s;
+	}
+
+	std::string tokenize(const ts::parser & p, const std::string & source)
+	{
+		std::size_t line = 1;
+		std::size_t column = 0;
+		std::string s;
+		p.parse_all(source.cbegin(), source.cend(), line, column, [&s](ts::tag_token && token)
+		{
+			s += ts::get_kind_name(ts::get_kind(token));
+			if (token.is_type<ts::open_tag>()) s += describe_tag(token.get<ts::open_tag>());
+			else if (token.is_type<ts::empty_tag>()) s += describe_tag(token.get<ts::empty_tag>());
+			else if (token.is_type<ts::closing_tag>()) s += " " + token.get<ts::closing_tag>().get_id();
+			s += "\n";
+		});
+		return s;
+	}
+
+	std::string describe(const ts::token_table & table)
+	{
+		std::string s;
+		for (std::size_t i = 0; i < table.size(); ++i)
+		{
+			const ts::tag_kind kind = table.get_kind(i);
+			s += ts::get_kind_name(kind);
+			if (kind == ts::tag_kind::open_tag || kind == ts::tag_kind::empty_tag || kind == ts::tag_kind::closing_tag)
+				s += " " + table.get_value(i).to_string();
+			for (std::size_t j = 0; j < table.count_attributes(i); ++j)
+				s += " " + table.get_attribute_name(i, j).to_string() + "=" + table.get_attribute_value(i, j).to_string();
+			s += "\n";
+		}
+		return s;
+	}
+
+}
+
+int main()
+{
+	ts::parser p;
+	std::vector<std::string> fragments =
+	{
+		"<a b=/>", "<a b=/x>", "<a href=x/>", "<a href=x>y</a>", "<a href = \"x y\" title='z'>",
+		"<input disabled>", "<input disabled/>", "<input disabled value=1 />", "<br/><br />", "<p class='a/b' id=c>"
+	};
+
+	// tags built from pieces which the tokenizer accepts in any order
+	const char * const names[] = {"a", "b", "data-x"};
+	const char * const values[] = {"", "=x", "=/", "=/x", "=x/y", "='q'", "=\"a b\"", " = v", "=//"};
+	const char * const ends[] = {">", "/>", " >", " />"};
+	std::mt19937 random(7);
+	for (int k = 0; k < 2000; ++k)
+	{
+		std::string tag = "<p";
+		for (int n = random() % 4; n > 0; --n) tag += std::string(" ") + names[random() % 3] + values[random() % 9];
+		fragments.push_back(tag + ends[random() % 4]);
+	}
+
+	bool passed = true;
+	for (const std::string & fragment : fragments)
+	{
+		const ts::token_table table(p, ts::document_view{fragment.data(), fragment.size()});
+		const std::string spanned = describe(table);
+		const std::string tokenized = tokenize(p, fragment);
+		if (spanned == tokenized) continue;
+		std::cerr << fragment << " has spans\n" << spanned << "but is tokenized as\n" << tokenized;
+		passed = false;
+	}
+	return passed ? 0 : 1;
+}
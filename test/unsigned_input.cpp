@@ -0,0 +1,42 @@
+/// @file unsigned_input.cpp
+/// @author Michael Koch
+/// @copyright CC BY 3.0
+/// @brief checks that ranges of unsigned char are tokenized like ranges of char
+
+#include <tagsoup/tagsoup.hpp>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static_assert(ts::is_contiguous_iterator<const char*>::value, "pointers to char are scanned in bulk!");
+static_assert(!ts::is_contiguous_iterator<const unsigned char*>::value, "pointers to unsigned char are scanned byte by byte!");
+static_assert(!ts::is_contiguous_iterator<std::vector<unsigned char>::iterator>::value, "vectors of unsigned char are scanned byte by byte!");
+
+template <typename Iterator>
+std::string tokenize(Iterator first, const Iterator last)
+{
+	ts::parser p;
+	std::size_t line = 1;
+	std::size_t column = 0;
+	std::string kinds;
+	p.parse_all(first, last, line, column, [&kinds](ts::tag_token && token)
+	{
+		kinds += ts::get_kind_name(ts::get_kind(token));
+		if (token.is_type<ts::text>()) kinds += " [" + token.get<ts::text>().get_content() + "]";
+		kinds += ' ';
+	});
+	return kinds;
+}
+
+int main()
+{
+	const std::string source = "<p class=x>h\xc3\xa9llo</p><!--c--><script>a<b</script>";
+	const std::string expected = tokenize(source.cbegin(), source.cend());
+
+	std::vector<unsigned char> bytes(source.begin(), source.end());
+	const unsigned char * p = bytes.data();
+	const bool same = tokenize(p, p + bytes.size()) == expected && tokenize(bytes.begin(), bytes.end()) == expected &&
+		tokenize(bytes.cbegin(), bytes.cend()) == expected;
+	if (!same) std::cerr << "unsigned char input is tokenized differently" << std::endl;
+	return same ? 0 : 1;
+}
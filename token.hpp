@@ -10,6 +10,7 @@
 #include <typeinfo>
 #include <cassert>
 #include <new>
+#include <cstdint>
 #include <tagsoup/type_algorithms.hpp>
 
 namespace ts
@@ -40,12 +41,12 @@ namespace ts
 
 		/// @brief constructor with parameter to set one of the inner values
 		/// @tparam X type of parameter
-		/// @note this constructor is only opted in, if type \a X is contained by the type list (\a T1, \a T2, \a Ts ...)
+		/// @note this constructor is only opted in, if the decayed type \a X is contained by the type list (\a T1, \a T2, \a Ts ...)
 		/// @param x value to set token
 		/// @details This constructor forwards the parameter \a to some auxiliary constructors which helps to find the
-		///				correct recursion level to set \a x
-		template <typename X, typename = typename std::enable_if<contains_type<X, T1, T2, Ts ...>::value>::type>
-		_token_values(X && x) : _token_values(std::forward<X>(x), std::integral_constant<bool, std::is_same<X, T1>::value>())
+		///				correct recursion level to set \a x. Rvalues are moved into place, lvalues are copied exactly once.
+		template <typename X, typename = typename std::enable_if<contains_type<typename std::decay<X>::type, T1, T2, Ts ...>::value>::type>
+		_token_values(X && x) : _token_values(std::forward<X>(x), std::integral_constant<bool, std::is_same<typename std::decay<X>::type, T1>::value>())
 		{}
 
 		/// @brief auxiliary constructor for the case that this is not the correct recursion level
@@ -273,36 +274,41 @@ namespace ts
 		using signature = token_signature<T, Ts ...>;
 
 		/// information about which type is active
-		const std::type_info & binded_type;
+		/// @note kept as pointer, so that tokens can be assigned
+		const std::type_info * binded_type;
+
+		/// bits the producer of the token may set to describe it further, zero by default
+		std::uint8_t flags;
 
 		/// union of specified types
 		_token_values<T, Ts ...> values;
 
-		/// @brief initialise if type is one of \a T or \a Ts
+		/// @brief initialise if the decayed type is one of \a T or \a Ts
 		/// @tparam X type of instance to initialise with
-		/// @param x instance to initialise
-		template <typename X, typename = typename std::enable_if<contains_type<X, T, Ts ...>::value>::type>
-		token(X && x) : binded_type(typeid(X)), values(std::forward<X>(x))
+		/// @param x instance to initialise; rvalues are moved, lvalues are copied once
+		template <typename X, typename = typename std::enable_if<contains_type<typename std::decay<X>::type, T, Ts ...>::value>::type>
+		token(X && x) : binded_type(&typeid(x)), flags(0), values(std::forward<X>(x))
 		{}
 
 		/// @brief move constructor
 		/// @param t instance to move from
-		token(token && t) : binded_type(t.binded_type)
+		/// @note declared noexcept, so that containers move tokens instead of copying them when growing
+		token(token && t) noexcept : binded_type(t.binded_type), flags(t.flags)
 		{
-			values.move(t.binded_type, std::move(t.values));
+			values.move(*t.binded_type, std::move(t.values));
 		}
 
 		/// @brief copy constructor
 		/// @param t instance to copy from
-		token(const token & t) : binded_type(t.binded_type)	
+		token(const token & t) : binded_type(t.binded_type), flags(t.flags)
 		{
-			values.copy(t.binded_type, t.values);
+			values.copy(*t.binded_type, t.values);
 		}
 		
 		/// @brief destructor destructs active value
 		~token()
 		{
-			values.dtr(binded_type);
+			values.dtr(*binded_type);
 		}
 
 		/// @brief copy assignment
@@ -311,9 +317,11 @@ namespace ts
 		/// @details currently active value will be destructed and active value of \a t will be copied
 		token& operator = (const token & t)
 		{
-			values.dtr(binded_type);
+			if (this == &t) return *this;
+			values.dtr(*binded_type);
 			binded_type = t.binded_type;
-			values.copy(binded_type, t.values);
+			flags = t.flags;
+			values.copy(*binded_type, t.values);
 			return *this;
 		}
 
@@ -321,11 +329,13 @@ namespace ts
 		/// @return this reference
 		/// @param t instance to move from
 		/// @details currently active value will be destructed and active value of \a t will be moved
-		token& operator = (token && t)
+		token& operator = (token && t) noexcept
 		{
-			values.dtr(binded_type);
+			if (this == &t) return *this;
+			values.dtr(*binded_type);
 			binded_type = t.binded_type;
-			values.move(binded_type, std::move(t.values));
+			flags = t.flags;
+			values.move(*binded_type, std::move(t.values));
 			return *this;
 		}
 
@@ -336,7 +346,7 @@ namespace ts
 		template <typename X> bool is_type() const
 		{
 			static_assert(contains_type<X, T, Ts ...>::value, "type X must be part of the class template type list!");
-			return typeid(X) == binded_type;
+			return typeid(X) == *binded_type;
 		}
 
 		/// @brief getter for value of type \a X
@@ -348,7 +358,7 @@ namespace ts
 		const X& get() const
 		{
 			static_assert(contains_type<X, T, Ts ...>::value, "type X must be part of the class template type list!");
-			assert(typeid(X) == binded_type);
+			assert(typeid(X) == *binded_type);
 			return values.template get<X>();
 		}
 
@@ -361,7 +371,7 @@ namespace ts
 		X& get()
 		{
 			static_assert(contains_type<X, T, Ts ...>::value, "type X must be part of the class template type list!");
-			assert(typeid(X) == binded_type);
+			assert(typeid(X) == *binded_type);
 			return values.template get<X>();
 		}
 	};
@@ -372,13 +382,13 @@ namespace ts
 	/// @tparam Ts rest of possible types the token can hold
 	/// @param x value to initialise token with
 	/// @param signature helps compiler to figure out which types the token can hold
-	/// @pre \a X must be contained by type list (\a T, \a Ts ...)
+	/// @pre decayed \a X must be contained by type list (\a T, \a Ts ...)
 	/// @pre type list (\a T, \a Ts ...) may not have any duplicate
 	/// @return token initialised with \a x
 	template <typename X, typename T, typename ... Ts>
 	token<T, Ts ...> make_token(X && x, const token_signature<T, Ts ...> signature)
 	{
-		static_assert(contains_type<X, T, Ts ...>::value, "type X is not contained by type list (T, Ts ...)");
+		static_assert(contains_type<typename std::decay<X>::type, T, Ts ...>::value, "type X is not contained by type list (T, Ts ...)");
 		static_assert(!contains_duplicate<T, Ts ...>::value, "type list (T, Ts ...) contains duplicates!");
 		return token<T, Ts ...>(std::forward<X>(x));
 	}
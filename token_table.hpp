@@ -0,0 +1,272 @@
+/// @file token_table.hpp
+/// @author Michael Koch
+/// @copyright CC BY 3.0
+
+#ifndef __TAGSOUP_TOKEN_TABLE_HPP__
+#define __TAGSOUP_TOKEN_TABLE_HPP__
+
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+#include <limits>
+#include <string>
+#include <vector>
+#include <tagsoup/parser.hpp>
+#include <tagsoup/document.hpp>
+#include <tagsoup/ascii.hpp>
+
+namespace ts
+{
+
+	/// @class token_table
+	/// @brief columnar representation of the tokens of one document
+	/// @details Instead of materialised tag tokens the table keeps one column per property: a kind byte, the span of
+	///			the token and the span of its value (id of tags, pi and dtd, content of text, comment and cdata), all
+	///			as offsets into the source document. Attributes live in a side table whose rows of one token are
+	///			found via \a first_attributes. A scan over some property therefore only touches the columns it needs.
+	///			The table does not own the source, which must outlive it and must not be larger than 4 GiB.
+	class token_table
+	{
+		private:
+			const char * source;
+
+			std::vector<std::uint8_t> kinds;
+			std::vector<std::uint32_t> offsets;
+			std::vector<std::uint32_t> lengths;
+			std::vector<std::uint32_t> value_offsets;
+			std::vector<std::uint32_t> value_lengths;
+
+			/// index of the first attribute of each token, plus one final entry with the total number of attributes
+			std::vector<std::uint32_t> first_attributes;
+
+			std::vector<std::uint32_t> attribute_name_offsets;
+			std::vector<std::uint32_t> attribute_name_lengths;
+			std::vector<std::uint32_t> attribute_value_offsets;
+			std::vector<std::uint32_t> attribute_value_lengths;
+
+			/// @brief finds the end of a name inside a tag
+			/// @param i first byte of the name
+			/// @param end end of the tag
+			/// @return first byte after the name
+			static const char * skip_name(const char * i, const char * end)
+			{
+				while (i != end && !is_space(*i) && *i != '>' && *i != '/' && *i != '=') ++i;
+				return i;
+			}
+
+			static const char * skip_spaces(const char * i, const char * end)
+			{
+				while (i != end && is_space(*i)) ++i;
+				return i;
+			}
+
+			/// @brief appends the attributes of an open or empty tag to the side table
+			/// @param i first byte after the tag id
+			/// @param end end of the tag
+			/// @details The tokenizer has accepted the tag, hence the walk only needs to find the borders.
+			void add_attributes(const char * i, const char * end)
+			{
+				while (true)
+				{
+					i = skip_spaces(i, end);
+					if (i == end || *i == '>' || *i == '/') break;
+
+					const char * name = i;
+					i = skip_name(i, end);
+					attribute_name_offsets.push_back(static_cast<std::uint32_t>(name - source));
+					attribute_name_lengths.push_back(static_cast<std::uint32_t>(i - name));
+
+					const char * value = i;
+					const char * value_end = i;
+					const char * after = skip_spaces(i, end);
+					if (after != end && *after == '=')
+					{
+						value = skip_spaces(after + 1, end);
+						if (value != end && (*value == '"' || *value == '\''))
+						{
+							const char quote = *value++;
+							value_end = value;
+							while (value_end != end && *value_end != quote) ++value_end;
+							i = value_end != end ? value_end + 1 : end;
+						}
+						else
+						{
+							// as in the tokenizer a '/' ends the value, e.g. <a href=x/>, unless it is the first byte
+							value_end = value != end && *value == '/' ? value + 1 : value;
+							while (value_end != end && !is_space(*value_end) && *value_end != '>' && *value_end != '/') ++value_end;
+							i = value_end;
+						}
+					}
+					attribute_value_offsets.push_back(static_cast<std::uint32_t>(value - source));
+					attribute_value_lengths.push_back(static_cast<std::uint32_t>(value_end - value));
+				}
+			}
+
+			/// @brief appends one row
+			/// @param kind kind of token
+			/// @param first first byte of token
+			/// @param last first byte after token
+			void add(const tag_kind kind, const char * first, const char * last)
+			{
+				const char * value = first;
+				const char * value_end = first;
+				const std::size_t length = last - first;
+				switch (kind)
+				{
+					case tag_kind::open_tag:
+					case tag_kind::empty_tag:
+						value = first + 1;
+						value_end = skip_name(value, last);
+						break;
+					case tag_kind::closing_tag:
+						value = first + 2;
+						value_end = skip_name(value, last);
+						break;
+					case tag_kind::pi:
+						value = first + 2;
+						value_end = value;
+						while (value_end != last && !is_space(*value_end) && *value_end != '?') ++value_end;
+						break;
+					case tag_kind::text:
+						value_end = last;
+						break;
+					case tag_kind::comment:
+						value = first + 4;
+						value_end = last - 3;
+						break;
+					case tag_kind::cdata:
+						value = first + 9;
+						value_end = last - 3;
+						break;
+					case tag_kind::dtd:
+						value = skip_spaces(first + 9, last - 1);
+						value_end = last - 1;
+						break;
+					default:
+						break;
+				}
+				if (value_end < value) value_end = value;
+
+				kinds.push_back(static_cast<std::uint8_t>(kind));
+				offsets.push_back(static_cast<std::uint32_t>(first - source));
+				lengths.push_back(static_cast<std::uint32_t>(length));
+				value_offsets.push_back(static_cast<std::uint32_t>(value - source));
+				value_lengths.push_back(static_cast<std::uint32_t>(value_end - value));
+				if (kind == tag_kind::open_tag || kind == tag_kind::empty_tag) add_attributes(value_end, last);
+				first_attributes.push_back(static_cast<std::uint32_t>(attribute_name_offsets.size()));
+			}
+
+		public:
+
+			token_table() : source(nullptr), first_attributes(1, 0) {}
+
+			/// @brief tokenizes a document into the table
+			/// @param tokenizer parser whose options are used; payload strings are skipped since spans replace them
+			/// @details A document exceeding the token or depth limit of \a tokenizer ends in an unknown_tag row
+			///			spanning the rest of the document.
+			/// @param document document to tokenize, must outlive the table
+			token_table(const parser & tokenizer, const document_view document) : source(document.data), first_attributes(1, 0)
+			{
+				assert(document.size <= std::numeric_limits<std::uint32_t>::max());
+
+				parser scanner(tokenizer);
+				scanner.skip_text(true);
+				scanner.skip_comment(true);
+				scanner.skip_cdata(true);
+				scanner.skip_pi(true);
+
+				size_t line = 1;
+				size_t column = 0;
+				parser::context current;
+				parser::usage used;
+				const char * start = document.begin();
+				const char * const end = document.end();
+				while (start != end)
+				{
+					auto result = scanner.parse(start, end, line, column, current);
+					const char * next = std::get<0>(result);
+					if (next == start || !scanner.account(std::get<1>(result), used))
+					{
+						add(tag_kind::unknown_tag, start, end);
+						break;
+					}
+					add(ts::get_kind(std::get<1>(result)), start, next);
+					start = next;
+				}
+			}
+
+			inline std::size_t size() const {return kinds.size();}
+			inline bool empty() const {return kinds.empty();}
+			inline const char * get_source() const {return source;}
+
+			inline tag_kind get_kind(const std::size_t i) const {return static_cast<tag_kind>(kinds[i]);}
+			inline std::uint32_t get_offset(const std::size_t i) const {return offsets[i];}
+			inline std::uint32_t get_length(const std::size_t i) const {return lengths[i];}
+
+			/// @brief gives the source bytes of a token
+			/// @param i row of token
+			/// @return view onto the whole token
+			inline document_view get_span(const std::size_t i) const {return document_view{source + offsets[i], lengths[i]};}
+
+			/// @brief gives the raw value of a token, i.e. the id of tags, pi and dtd or the content of text, comment and cdata
+			/// @param i row of token
+			/// @return view onto the value as it appears in the source (neither lowered nor unescaped)
+			inline document_view get_value(const std::size_t i) const {return document_view{source + value_offsets[i], value_lengths[i]};}
+
+			inline std::size_t count_attributes(const std::size_t i) const {return first_attributes[i + 1] - first_attributes[i];}
+
+			/// @brief gives the name of an attribute
+			/// @param i row of token
+			/// @param j index of attribute within the token
+			/// @return view onto the name
+			inline document_view get_attribute_name(const std::size_t i, const std::size_t j) const
+			{
+				const std::size_t k = first_attributes[i] + j;
+				return document_view{source + attribute_name_offsets[k], attribute_name_lengths[k]};
+			}
+
+			/// @brief gives the value of an attribute
+			/// @param i row of token
+			/// @param j index of attribute within the token
+			/// @return view onto the raw value without quotes
+			inline document_view get_attribute_value(const std::size_t i, const std::size_t j) const
+			{
+				const std::size_t k = first_attributes[i] + j;
+				return document_view{source + attribute_value_offsets[k], attribute_value_lengths[k]};
+			}
+
+			/// @brief column of kinds, one byte per token holding a tag_kind
+			inline const std::vector<std::uint8_t>& get_kinds() const {return kinds;}
+
+			/// @brief counts tokens of some kind whose value equals \a value ignoring ASCII case
+			/// @param kind kind of tokens to count
+			/// @param value wanted value, e.g. a tag id
+			/// @return number of matching tokens
+			/// @details touches only the kind and value columns and the source bytes of candidates of equal length
+			std::size_t count(const tag_kind kind, const std::string & value) const
+			{
+				std::size_t n = 0;
+				const std::uint8_t wanted = static_cast<std::uint8_t>(kind);
+				for (std::size_t i = 0; i < kinds.size(); ++i)
+				{
+					if (kinds[i] != wanted || value_lengths[i] != value.size()) continue;
+					const char * candidate = source + value_offsets[i];
+					std::size_t j = 0;
+					while (j < value.size() && equals_ignoring_case(candidate[j], value[j])) ++j;
+					if (j == value.size()) ++n;
+				}
+				return n;
+			}
+
+			/// @brief gives the number of bytes held by the table itself
+			/// @return bytes of all columns (capacity is not taken into account)
+			std::size_t get_memory_size() const
+			{
+				return kinds.size() * (sizeof(std::uint8_t) + 5 * sizeof(std::uint32_t)) + sizeof(std::uint32_t)
+					+ attribute_name_offsets.size() * 4 * sizeof(std::uint32_t);
+			}
+	};
+
+}
+
+#endif
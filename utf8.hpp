@@ -0,0 +1,187 @@
+/// @file utf8.hpp
+/// @author Michael Koch
+/// @copyright CC BY 3.0
+
+#ifndef __TAGSOUP_UTF8_HPP__
+#define __TAGSOUP_UTF8_HPP__
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+namespace ts
+{
+
+	/// @brief what the tokenizer does about invalid UTF-8 in payloads
+	enum class utf8_validation : std::uint8_t
+	{
+		/// payloads are not checked
+		none = 0,
+		/// tokens with invalid payloads get the tag_flag::invalid_utf8 bit
+		flag,
+		/// invalid sequences are replaced by U+FFFD, the token gets the tag_flag::invalid_utf8 bit as well
+		replace
+	};
+
+	/// @brief measures the sequence at the start of some bytes
+	/// @param p first byte of the sequence, must not be ASCII
+	/// @param n number of available bytes, at least one
+	/// @param valid set to whether the sequence is well formed
+	/// @return length of the well formed sequence, or the length of the maximal ill formed subpart which is to be
+	///			replaced by a single U+FFFD
+	inline std::size_t measure_utf8(const unsigned char * p, const std::size_t n, bool & valid)
+	{
+		const unsigned char b = p[0];
+		std::size_t length;
+		unsigned char low = 0x80;
+		unsigned char high = 0xBF;
+		if (b >= 0xC2 && b <= 0xDF) length = 2;
+		else if (b >= 0xE0 && b <= 0xEF)
+		{
+			length = 3;
+			if (b == 0xE0) low = 0xA0;
+			else if (b == 0xED) high = 0x9F;
+		}
+		else if (b >= 0xF0 && b <= 0xF4)
+		{
+			length = 4;
+			if (b == 0xF0) low = 0x90;
+			else if (b == 0xF4) high = 0x8F;
+		}
+		else
+		{
+			valid = false;
+			return 1;
+		}
+
+		for (std::size_t i = 1; i < length; ++i)
+		{
+			const unsigned char lower = i == 1 ? low : 0x80;
+			const unsigned char upper = i == 1 ? high : 0xBF;
+			if (i >= n || p[i] < lower || p[i] > upper)
+			{
+				valid = false;
+				return i;
+			}
+		}
+		valid = true;
+		return length;
+	}
+
+	/// @brief tells whether a byte continues a multi byte sequence
+	inline bool is_utf8_continuation(const char c) {return (static_cast<unsigned char>(c) & 0xC0) == 0x80;}
+
+	/// @brief gives the number of bytes a sequence announces by its first byte
+	/// @param c first byte of the sequence
+	/// @return 2 to 4 for a lead byte, 1 for anything else
+	inline std::size_t get_utf8_length(const char c)
+	{
+		const unsigned char b = static_cast<unsigned char>(c);
+		if (b >= 0xC2 && b <= 0xDF) return 2;
+		else if (b >= 0xE0 && b <= 0xEF) return 3;
+		else if (b >= 0xF0 && b <= 0xF4) return 4;
+		return 1;
+	}
+
+	/// @brief moves a cut through some bytes onto a character boundary
+	/// @tparam ForwardIterator type concept forward iterator
+	/// @param first first byte of the piece in front of the cut
+	/// @param cut first byte after the piece
+	/// @param end first iterator after all bytes
+	/// @return \a cut moved back in front of the character it would split, or moved behind that character if it is
+	///			the only one of the piece; \a cut itself if it does not split a well formed lead of a character
+	template <typename ForwardIterator>
+	ForwardIterator align_utf8_cut(const ForwardIterator first, const ForwardIterator cut, const ForwardIterator end)
+	{
+		if (cut == end || !is_utf8_continuation(*cut)) return cut;
+		ForwardIterator lead = first;
+		std::size_t behind = 0;
+		for (ForwardIterator i = first; i != cut; ++i)
+		{
+			if (!is_utf8_continuation(*i)) {lead = i; behind = 0;}
+			++behind;
+		}
+		if (behind == 0 || is_utf8_continuation(*lead) || get_utf8_length(*lead) <= behind) return cut;
+		if (lead != first) return lead;
+
+		ForwardIterator i = cut;
+		for (std::size_t k = behind; i != end && k < get_utf8_length(*lead) && is_utf8_continuation(*i); ++k) ++i;
+		return i;
+	}
+
+	/// @brief finds the first ill formed sequence
+	/// @param data first byte to check
+	/// @param size number of bytes to check
+	/// @return offset of the first ill formed sequence or \a size if all bytes are well formed
+	/// @details ASCII runs are skipped eight bytes at a time with a single mask test per word.
+	inline std::size_t find_invalid_utf8(const char * data, const std::size_t size)
+	{
+		const unsigned char * p = reinterpret_cast<const unsigned char*>(data);
+		std::size_t i = 0;
+		while (i < size)
+		{
+			if (i + 8 <= size)
+			{
+				std::uint64_t word;
+				std::memcpy(&word, p + i, 8);
+				if ((word & 0x8080808080808080ull) == 0)
+				{
+					i += 8;
+					continue;
+				}
+			}
+			if (p[i] < 0x80)
+			{
+				++i;
+				continue;
+			}
+			bool valid;
+			const std::size_t length = measure_utf8(p + i, size - i, valid);
+			if (!valid) return i;
+			i += length;
+		}
+		return size;
+	}
+
+	/// @brief tests whether a string is well formed UTF-8
+	/// @param s string to test
+	/// @retval true all sequences are well formed
+	/// @retval false there is some ill formed sequence
+	inline bool is_valid_utf8(const std::string & s)
+	{
+		return find_invalid_utf8(s.data(), s.size()) == s.size();
+	}
+
+	/// @brief replaces every maximal ill formed subpart by U+FFFD
+	/// @param s string to repair in place
+	/// @retval true something has been replaced
+	/// @retval false \a s has been well formed
+	inline bool repair_utf8(std::string & s)
+	{
+		std::size_t i = find_invalid_utf8(s.data(), s.size());
+		if (i == s.size()) return false;
+
+		std::string repaired(s, 0, i);
+		repaired.reserve(s.size() + 8);
+		const unsigned char * p = reinterpret_cast<const unsigned char*>(s.data());
+		while (i < s.size())
+		{
+			if (p[i] < 0x80)
+			{
+				repaired.push_back(s[i++]);
+				continue;
+			}
+			bool valid;
+			const std::size_t length = measure_utf8(p + i, s.size() - i, valid);
+			if (valid) repaired.append(s, i, length);
+			else repaired.append("\xEF\xBF\xBD");
+			i += length;
+		}
+		s.swap(repaired);
+		return true;
+	}
+
+}
+
+#endif
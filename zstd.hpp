@@ -0,0 +1,74 @@
+/// @file zstd.hpp
+/// @author Michael Koch
+/// @copyright CC BY 3.0
+/// @note needs zstd, link with -lzstd
+
+#ifndef __TAGSOUP_ZSTD_HPP__
+#define __TAGSOUP_ZSTD_HPP__
+
+#include <cstddef>
+#include <vector>
+#include <zstd.h>
+
+namespace ts
+{
+
+	/// @class zstd_source
+	/// @brief source decompressing the zstd compressed document of another source
+	/// @tparam Source class with a method std::size_t read(char * buffer, std::size_t size)
+	/// @details Works like gzip_source: compressed bytes go through a reused buffer of the size recommended by zstd
+	///			and are decompressed straight into the buffer of the caller. Concatenated frames are decompressed one
+	///			after the other. Corrupt or truncated input ends the document early and marks the source as failed.
+	template <typename Source>
+	class zstd_source
+	{
+		private:
+			Source & source;
+			ZSTD_DCtx * context;
+			std::vector<char> raw;
+			ZSTD_inBuffer input;
+			bool exhausted;
+			bool complete;
+			bool broken;
+
+		public:
+			/// @param source source of the compressed document
+			zstd_source(Source & source) :
+				source(source), context(ZSTD_createDCtx()), raw(ZSTD_DStreamInSize()), input{raw.data(), 0, 0},
+				exhausted(false), complete(true), broken(context == nullptr)
+			{}
+
+			zstd_source(const zstd_source &) = delete;
+			zstd_source& operator = (const zstd_source &) = delete;
+
+			~zstd_source() {ZSTD_freeDCtx(context);}
+
+			/// @brief tells whether the compressed document has been corrupt or truncated
+			inline bool failed() const {return broken;}
+
+			std::size_t read(char * buffer, const std::size_t wanted)
+			{
+				ZSTD_outBuffer output{buffer, wanted, 0};
+				while (output.pos == 0 && wanted != 0 && !broken)
+				{
+					if (input.pos == input.size && !exhausted)
+					{
+						input.size = source.read(raw.data(), raw.size());
+						input.pos = 0;
+						if (input.size == 0) exhausted = true;
+					}
+					if (input.pos == input.size && exhausted && complete) break;
+
+					// zero tells that a frame is complete; another frame may follow
+					const std::size_t result = ZSTD_decompressStream(context, &output, &input);
+					if (ZSTD_isError(result)) broken = true;
+					else complete = result == 0;
+					if (!complete && exhausted && input.pos == input.size && output.pos == 0) broken = true;
+				}
+				return output.pos;
+			}
+	};
+
+}
+
+#endif